@@ -1,20 +1,87 @@
+export 'src/collector_stats.dart';
+export 'src/fd_collection.dart';
+export 'src/file_usage.dart';
 export 'src/fd_report_dialog.dart';
 export 'src/fd_info.dart';
+export 'src/fd_pressure.dart';
+export 'src/fd_range_result.dart';
+export 'src/fd_snapshot.dart';
+export 'src/fd_summary.dart';
+export 'src/fd_trace.dart';
 export 'src/nofile_limit.dart';
 export 'src/nofile_limit_result.dart';
+export 'src/shm_publisher.dart';
+export 'src/unix_socket_peer.dart';
+
+import 'dart:convert';
+import 'dart:typed_data';
 
 import 'flutter_fd_utils_platform_interface.dart';
+import 'src/collector_stats.dart';
+import 'src/fd_collection.dart';
+import 'src/file_usage.dart';
 import 'src/fd_info.dart';
+import 'src/fd_pressure.dart';
+import 'src/fd_range_result.dart';
+import 'src/fd_snapshot.dart';
+import 'src/fd_trace.dart';
 import 'src/nofile_limit.dart';
 import 'src/nofile_limit_result.dart';
+import 'src/shm_publisher.dart';
+import 'src/unix_socket_peer.dart';
 
 /// A thin Dart wrapper around the platform implementation.
 class FlutterFdUtils {
   const FlutterFdUtils();
 
   /// Returns a human-readable report of the current process file descriptors.
-  Future<String> getFdReport() {
-    return FlutterFdUtilsPlatform.instance.getFdReport();
+  ///
+  /// On Linux, concurrent callers share one collection, and a cached snapshot
+  /// no older than [maxAge] (or the default set by [setSnapshotCacheMaxAge])
+  /// is reused instead of collecting again.
+  ///
+  /// Passing a [budget] runs a fresh collection that stops early when the
+  /// budget runs out (the report then contains a `truncated_at_fd` line).
+  /// With a [cancelToken], calling [cancelFdCollection] stops that collection
+  /// and makes the call fail with a `cancelled` [PlatformException]. The token
+  /// only applies together with a [budget]; without one the report comes
+  /// from the shared snapshot cache and cannot be cancelled.
+  Future<String> getFdReport({
+    Duration? maxAge,
+    FdCollectionBudget? budget,
+    FdCancellationToken? cancelToken,
+  }) {
+    return FlutterFdUtilsPlatform.instance.getFdReport(
+      maxAge: maxAge,
+      budget: budget,
+      cancelToken: cancelToken,
+    );
+  }
+
+  /// Streams the fd report as NDJSON chunks (Linux).
+  ///
+  /// The native side probes one descriptor at a time and never holds more
+  /// than about [chunkSize] bytes of output (clamped to 4 KiB..4 MiB), so this
+  /// is the way to report on very large fd tables. Records may span chunk
+  /// boundaries; use [streamFdReportRecords] to get parsed records. Cancelling
+  /// the subscription stops the native collection.
+  Stream<Uint8List> streamFdReportChunks({int chunkSize = 64 * 1024}) {
+    return FlutterFdUtilsPlatform.instance.streamFdReportChunks(chunkSize: chunkSize);
+  }
+
+  /// Decodes [streamFdReportChunks] into records: one `header`, one `fd`
+  /// record per descriptor, and a final `summary` (see the `type` key).
+  /// `fd` records have the keys of a [getFdList] entry, so
+  /// [FdInfo.fromMap] parses them.
+  Stream<Map<String, Object?>> streamFdReportRecords({int chunkSize = 64 * 1024}) {
+    return streamFdReportChunks(chunkSize: chunkSize)
+        .cast<List<int>>()
+        // The native side escapes non-UTF-8 path bytes; stay lenient anyway
+        // so one odd record cannot end the stream.
+        .transform(const Utf8Decoder(allowMalformed: true))
+        .transform(const LineSplitter())
+        .where((String line) => line.isNotEmpty)
+        .map((String line) => (jsonDecode(line) as Map<Object?, Object?>).cast<String, Object?>());
   }
 
   /// Returns the current process RLIMIT_NOFILE limits.
@@ -32,9 +99,132 @@ class FlutterFdUtils {
     return FlutterFdUtilsPlatform.instance.getNofileHardLimit();
   }
 
+  /// Returns rolling latency histograms per collection phase and per method
+  /// (Linux). Pass [reset] to start a fresh window after reading.
+  Future<FdCollectorStats> getCollectorStats({bool reset = false}) {
+    return FlutterFdUtilsPlatform.instance.getCollectorStats(reset: reset);
+  }
+
+  /// Returns system-wide fd, inotify and epoll limits next to this process's
+  /// usage, with headroom ratios (Linux).
+  Future<FdPressure> getFdPressure() {
+    return FlutterFdUtilsPlatform.instance.getFdPressure();
+  }
+
   /// Returns a structured list of current process file descriptors.
-  Future<List<FdInfo>> getFdList() {
-    return FlutterFdUtilsPlatform.instance.getFdList();
+  ///
+  /// See [getFdReport] for how [maxAge] is applied. The list carries no phase
+  /// timings; [getFdSnapshot] and [getFdListPage] return them alongside it.
+  Future<List<FdInfo>> getFdList({Duration? maxAge}) {
+    return FlutterFdUtilsPlatform.instance.getFdList(maxAge: maxAge);
+  }
+
+  /// Returns the report, the structured list and a summary taken from one
+  /// collection (Linux), for callers that would otherwise call both
+  /// [getFdReport] and [getFdList].
+  ///
+  /// See [getFdReport] for how [maxAge] is applied.
+  Future<FdSnapshot> getFdSnapshot({Duration? maxAge}) {
+    return FlutterFdUtilsPlatform.instance.getFdSnapshot(maxAge: maxAge);
+  }
+
+  /// Returns one page of the fd list (Linux).
+  ///
+  /// If [FdListPage.truncated] is set, call again with
+  /// `FdCollectionBudget(startFd: page.nextFd!)` to continue.
+  Future<FdListPage> getFdListPage({
+    FdCollectionBudget budget = const FdCollectionBudget(),
+    FdCancellationToken? cancelToken,
+  }) {
+    return FlutterFdUtilsPlatform.instance.getFdListPage(
+      budget: budget,
+      cancelToken: cancelToken,
+    );
+  }
+
+  /// Cancels the collection started with [token]; returns false if it had
+  /// already finished or was not budgeted.
+  Future<bool> cancelFdCollection(FdCancellationToken token) {
+    return FlutterFdUtilsPlatform.instance.cancelFdCollection(token);
+  }
+
+  /// Returns regular files held open and/or mapped by the process (Linux).
+  ///
+  /// Descriptors and `/proc/self/maps` are read back to back and joined by
+  /// (dev, inode), so files that were deleted while open, or are still mapped
+  /// after being closed, show up together with the disk space they pin.
+  Future<FileUsageReport> getFileUsage() {
+    return FlutterFdUtilsPlatform.instance.getFileUsage();
+  }
+
+  /// Returns this process's unix sockets with the pid, fd and command name
+  /// of the process holding each peer (Linux).
+  ///
+  /// Peers come from a sock_diag query; their owners are found through an
+  /// inode index that is kept across calls, so repeated calls only rescan
+  /// processes when a peer is new. See [getFdReport] for how [maxAge] is
+  /// applied.
+  Future<UnixSocketPeerReport> getUnixSocketPeers({Duration? maxAge}) {
+    return FlutterFdUtilsPlatform.instance.getUnixSocketPeers(maxAge: maxAge);
+  }
+
+  /// Marks every open descriptor in [first]..[last] (default: the highest
+  /// possible fd) close-on-exec, so spawned helpers do not inherit them
+  /// (Linux).
+  ///
+  /// Uses close_range(CLOSE_RANGE_CLOEXEC) where available and a
+  /// /proc/self/fd loop otherwise.
+  Future<FdRangeResult> setCloexecRange(int first, [int? last]) {
+    return FlutterFdUtilsPlatform.instance.setCloexecRange(first, last);
+  }
+
+  /// Closes every open descriptor in [first]..[last] (Linux).
+  ///
+  /// This also closes descriptors owned by the engine or other libraries in
+  /// the range; only use it on ranges your code owns. The plugin's own
+  /// descriptors (emergency dump, trace file, shared-memory segment, io_uring
+  /// ring, and those of plugin calls still running in the background) are
+  /// skipped.
+  Future<FdRangeResult> closeRange(int first, [int? last]) {
+    return FlutterFdUtilsPlatform.instance.closeRange(first, last);
+  }
+
+  /// Lists descriptors that would leak into an exec'd child because they lack
+  /// FD_CLOEXEC (Linux). stdin/stdout/stderr are skipped unless
+  /// [includeStdio] is true.
+  Future<List<FdInfo>> getNonCloexecFds({bool includeStdio = false}) {
+    return FlutterFdUtilsPlatform.instance.getNonCloexecFds(includeStdio: includeStdio);
+  }
+
+  /// Sets the default maximum age of the native snapshot cache (Linux).
+  ///
+  /// [Duration.zero] (the default) only coalesces requests that overlap.
+  Future<void> setSnapshotCacheMaxAge(Duration maxAge) {
+    return FlutterFdUtilsPlatform.instance.setSnapshotCacheMaxAge(maxAge);
+  }
+
+  /// Selects how native collection passes probe descriptors (Linux).
+  ///
+  /// [FdProbeBackend.ioUring] batches the per-descriptor stat and flag reads
+  /// into a few io_uring submissions; whether that is faster depends on the
+  /// kernel and core count (see `linux/benchmark/collect_benchmark.cc`).
+  /// Where io_uring is unavailable (kernels before 5.18, seccomp,
+  /// io_uring_disabled) the collector keeps using syscalls; the returned value
+  /// is the backend actually in effect.
+  Future<FdProbeBackend> setFdProbeBackend(FdProbeBackend backend) {
+    return FlutterFdUtilsPlatform.instance.setFdProbeBackend(backend);
+  }
+
+  /// Selects whether native collection passes detect descriptors that were
+  /// closed and reused by another thread while being probed (Linux).
+  ///
+  /// Each descriptor is stat'ed again after probing and its (dev, inode)
+  /// compared with the first stat, at the cost of one extra `fstat` per
+  /// descriptor. [FdConsistencyMode.mark] flags mismatches as [FdInfo.torn];
+  /// [FdConsistencyMode.retry] probes them again first. Applies to every
+  /// later collection, including cached snapshots and streamed reports.
+  Future<void> setFdConsistencyMode(FdConsistencyMode mode) {
+    return FlutterFdUtilsPlatform.instance.setFdConsistencyMode(mode);
   }
 
   /// Attempts to update the soft RLIMIT_NOFILE (nofile) limit.
@@ -50,4 +240,94 @@ class FlutterFdUtils {
       clampToHardLimit: clampToHardLimit,
     );
   }
+
+  /// Preallocates an emergency fd dumper that appends snapshots to [path].
+  ///
+  /// The dump is written with raw syscalls only, so it still works from a
+  /// signal handler or once the process has run out of file descriptors. It is
+  /// triggered by [triggerSignal] (e.g. SIGUSR2), by fatal signals when
+  /// [dumpOnFatalSignal] is true, and by the first EMFILE/ENFILE seen by the
+  /// plugin when [dumpOnEmfile] is true.
+  ///
+  /// Currently implemented on Linux only.
+  Future<void> enableEmergencyFdDump(
+    String path, {
+    int? triggerSignal,
+    bool dumpOnFatalSignal = true,
+    bool dumpOnEmfile = true,
+  }) {
+    return FlutterFdUtilsPlatform.instance.enableEmergencyFdDump(
+      path,
+      triggerSignal: triggerSignal,
+      dumpOnFatalSignal: dumpOnFatalSignal,
+      dumpOnEmfile: dumpOnEmfile,
+    );
+  }
+
+  /// Removes the emergency fd dumper installed by [enableEmergencyFdDump].
+  Future<void> disableEmergencyFdDump() {
+    return FlutterFdUtilsPlatform.instance.disableEmergencyFdDump();
+  }
+
+  /// Writes an emergency fd dump now and returns the number of bytes written.
+  Future<int> triggerEmergencyFdDump() {
+    return FlutterFdUtilsPlatform.instance.triggerEmergencyFdDump();
+  }
+
+  /// Publishes fd counters and a compact snapshot into shared memory so an
+  /// external agent can read them without calling into the app (Linux).
+  ///
+  /// A background monitor refreshes the segment every [interval] under a
+  /// seqlock. With a [name] (e.g. `/my_app.fds`) the segment is a POSIX shm
+  /// object under `/dev/shm`; without one it is an anonymous memfd. At most
+  /// [capacity] entries are published. Replaces a running publisher. An
+  /// existing object of the same name that this publisher did not create is
+  /// left alone, and the call fails with `shm_publisher_failed` (EEXIST).
+  Future<ShmPublisherInfo> enableShmPublisher({
+    String? name,
+    Duration interval = const Duration(seconds: 1),
+    int capacity = 4096,
+  }) {
+    return FlutterFdUtilsPlatform.instance.enableShmPublisher(
+      name: name,
+      interval: interval,
+      capacity: capacity,
+    );
+  }
+
+  /// Stops the publisher and removes its segment.
+  Future<void> disableShmPublisher() {
+    return FlutterFdUtilsPlatform.instance.disableShmPublisher();
+  }
+
+  /// Records the fd table into a Chrome trace-event JSON file at [path]
+  /// (Linux), for chrome://tracing or ui.perfetto.dev.
+  ///
+  /// Every [interval] the background monitor adds counter tracks per fd type,
+  /// and diffs against the previous sample to begin or end one slice per
+  /// descriptor lifetime on an "fd <n>" track. Output is streamed to the file,
+  /// so memory stays flat however long it runs; pass [maxBytes] to also cap
+  /// the file size. Replaces a running trace.
+  Future<FdTraceInfo> startFdTrace(
+    String path, {
+    Duration interval = const Duration(seconds: 1),
+    int? maxBytes,
+  }) {
+    return FlutterFdUtilsPlatform.instance.startFdTrace(
+      path,
+      interval: interval,
+      maxBytes: maxBytes,
+    );
+  }
+
+  /// Returns the progress of the running trace.
+  Future<FdTraceInfo> getFdTraceInfo() {
+    return FlutterFdUtilsPlatform.instance.getFdTraceInfo();
+  }
+
+  /// Ends the open slices, finishes the trace file and returns its final
+  /// statistics.
+  Future<FdTraceInfo> stopFdTrace() {
+    return FlutterFdUtilsPlatform.instance.stopFdTrace();
+  }
 }
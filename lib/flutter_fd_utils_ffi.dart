@@ -0,0 +1,9 @@
+/// Synchronous dart:ffi fast path for the Linux implementation.
+///
+/// Kept out of `flutter_fd_utils.dart` so that library stays usable on
+/// platforms without `dart:ffi`.
+library;
+
+export 'src/fd_summary.dart';
+export 'src/fd_utils_ffi.dart';
+export 'src/nofile_limit.dart';
@@ -1,10 +1,22 @@
+import 'dart:typed_data';
+
 import 'package:flutter/foundation.dart';
 import 'package:flutter/services.dart';
 
 import 'flutter_fd_utils_platform_interface.dart';
+import 'src/collector_stats.dart';
+import 'src/file_usage.dart';
+import 'src/fd_collection.dart';
 import 'src/fd_info.dart';
+import 'src/fd_pressure.dart';
+import 'src/fd_range_result.dart';
+import 'src/fd_snapshot.dart';
+import 'src/fd_summary.dart';
+import 'src/fd_trace.dart';
 import 'src/nofile_limit.dart';
 import 'src/nofile_limit_result.dart';
+import 'src/shm_publisher.dart';
+import 'src/unix_socket_peer.dart';
 
 /// An implementation of [FlutterFdUtilsPlatform] that uses method channels.
 class MethodChannelFlutterFdUtils extends FlutterFdUtilsPlatform {
@@ -12,12 +24,49 @@ class MethodChannelFlutterFdUtils extends FlutterFdUtilsPlatform {
   @visibleForTesting
   final methodChannel = const MethodChannel('flutter_fd_utils');
 
+  /// The event channel that delivers NDJSON report chunks.
+  @visibleForTesting
+  final reportStreamChannel = const EventChannel('flutter_fd_utils/fd_report_stream');
+
+  Map<String, Object?>? _maxAgeArgs(Duration? maxAge) {
+    if (maxAge == null) return null;
+    return <String, Object?>{'maxAgeMs': maxAge.inMilliseconds};
+  }
+
+  Map<String, Object?>? _collectArgs(
+    Duration? maxAge,
+    FdCollectionBudget? budget,
+    FdCancellationToken? cancelToken,
+  ) {
+    if (maxAge == null && budget == null && cancelToken == null) return null;
+    return <String, Object?>{
+      if (maxAge != null) 'maxAgeMs': maxAge.inMilliseconds,
+      ...?budget?.toArguments(),
+      if (cancelToken != null) 'requestId': cancelToken.id,
+    };
+  }
+
   @override
-  Future<String> getFdReport() async {
-    final Object? report = await methodChannel.invokeMethod('getFdReport');
+  Future<String> getFdReport({
+    Duration? maxAge,
+    FdCollectionBudget? budget,
+    FdCancellationToken? cancelToken,
+  }) async {
+    final Object? report = await methodChannel.invokeMethod(
+      'getFdReport',
+      _collectArgs(maxAge, budget, cancelToken),
+    );
     return report?.toString() ?? '';
   }
 
+  @override
+  Stream<Uint8List> streamFdReportChunks({int chunkSize = 64 * 1024}) {
+    return reportStreamChannel
+        .receiveBroadcastStream(<String, Object?>{'chunkSize': chunkSize})
+        .where((Object? chunk) => chunk is Uint8List)
+        .cast<Uint8List>();
+  }
+
   @override
   Future<NofileLimit> getNofileLimit() async {
     final Object? raw = await methodChannel.invokeMethod('getNofileLimit');
@@ -44,8 +93,21 @@ class MethodChannelFlutterFdUtils extends FlutterFdUtilsPlatform {
   }
 
   @override
-  Future<List<FdInfo>> getFdList() async {
-    final Object? raw = await methodChannel.invokeMethod('getFdList');
+  Future<FdCollectorStats> getCollectorStats({bool reset = false}) async {
+    final Object? raw = await methodChannel.invokeMethod(
+      'getCollectorStats',
+      <String, Object?>{'reset': reset},
+    );
+    return FdCollectorStats.fromMap(raw is Map ? raw.cast<Object?, Object?>() : const <Object?, Object?>{});
+  }
+
+  @override
+  Future<FdPressure> getFdPressure() async {
+    final Object? raw = await methodChannel.invokeMethod('getFdPressure');
+    return FdPressure.fromMap(raw is Map ? raw.cast<Object?, Object?>() : const <Object?, Object?>{});
+  }
+
+  List<FdInfo> _fdListFromRaw(Object? raw) {
     if (raw is List) {
       return raw
           .whereType<Map>()
@@ -55,6 +117,25 @@ class MethodChannelFlutterFdUtils extends FlutterFdUtilsPlatform {
     return const <FdInfo>[];
   }
 
+  @override
+  Future<List<FdInfo>> getFdList({Duration? maxAge}) async {
+    final Object? raw = await methodChannel.invokeMethod('getFdList', _maxAgeArgs(maxAge));
+    return _fdListFromRaw(raw);
+  }
+
+  @override
+  Future<FdSnapshot> getFdSnapshot({Duration? maxAge}) async {
+    final Object? raw = await methodChannel.invokeMethod('getFdSnapshot', _maxAgeArgs(maxAge));
+    if (raw is Map) {
+      return FdSnapshot.fromMap(raw.cast<Object?, Object?>());
+    }
+    return FdSnapshot(
+      report: '',
+      entries: const <FdInfo>[],
+      summary: FdSummary.fromMap(const <Object?, Object?>{}),
+    );
+  }
+
   @override
   Future<NofileLimitResult> setNofileSoftLimit(
     int softLimit, {
@@ -85,4 +166,190 @@ class MethodChannelFlutterFdUtils extends FlutterFdUtilsPlatform {
       errorMessage: 'Unexpected platform response',
     );
   }
+
+  @override
+  Future<FdListPage> getFdListPage({
+    FdCollectionBudget budget = const FdCollectionBudget(),
+    FdCancellationToken? cancelToken,
+  }) async {
+    final Object? raw = await methodChannel.invokeMethod(
+      'getFdListPage',
+      _collectArgs(null, budget, cancelToken),
+    );
+    if (raw is Map) {
+      return FdListPage.fromMap(raw.cast<Object?, Object?>());
+    }
+    return const FdListPage(entries: <FdInfo>[], truncated: false);
+  }
+
+  @override
+  Future<bool> cancelFdCollection(FdCancellationToken token) async {
+    final Object? raw = await methodChannel.invokeMethod(
+      'cancelFdCollection',
+      <String, Object?>{'requestId': token.id},
+    );
+    return raw == true;
+  }
+
+  @override
+  Future<FileUsageReport> getFileUsage() async {
+    final Object? raw = await methodChannel.invokeMethod('getFileUsage');
+    if (raw is Map) {
+      return FileUsageReport.fromMap(raw.cast<Object?, Object?>());
+    }
+    return const FileUsageReport(files: <FileUsage>[], deletedFileCount: 0, deletedReclaimableBytes: 0);
+  }
+
+  @override
+  Future<UnixSocketPeerReport> getUnixSocketPeers({Duration? maxAge}) async {
+    final Object? raw = await methodChannel.invokeMethod('getUnixSocketPeers', _maxAgeArgs(maxAge));
+    if (raw is Map) {
+      return UnixSocketPeerReport.fromMap(raw.cast<Object?, Object?>());
+    }
+    return const UnixSocketPeerReport(sockets: <UnixSocketPeer>[], diagErrno: 0, processesScanned: 0);
+  }
+
+  Future<FdRangeResult> _fdRange(String method, int first, int? last) async {
+    final Object? raw = await methodChannel.invokeMethod(
+      method,
+      <String, Object?>{'first': first, if (last != null) 'last': last},
+    );
+    if (raw is Map) {
+      return FdRangeResult.fromMap(raw.cast<Object?, Object?>());
+    }
+    return const FdRangeResult(
+      success: false,
+      usedCloseRange: false,
+      errno: 0,
+      errorMessage: 'Unexpected platform response',
+    );
+  }
+
+  @override
+  Future<FdRangeResult> setCloexecRange(int first, [int? last]) {
+    return _fdRange('setCloexecRange', first, last);
+  }
+
+  @override
+  Future<FdRangeResult> closeRange(int first, [int? last]) {
+    return _fdRange('closeRange', first, last);
+  }
+
+  @override
+  Future<List<FdInfo>> getNonCloexecFds({bool includeStdio = false}) async {
+    final Object? raw = await methodChannel.invokeMethod(
+      'getNonCloexecFds',
+      <String, Object?>{'includeStdio': includeStdio},
+    );
+    return _fdListFromRaw(raw);
+  }
+
+  @override
+  Future<void> setSnapshotCacheMaxAge(Duration maxAge) async {
+    await methodChannel.invokeMethod<void>(
+      'setSnapshotCacheMaxAge',
+      <String, Object?>{'maxAgeMs': maxAge.inMilliseconds},
+    );
+  }
+
+  @override
+  Future<FdProbeBackend> setFdProbeBackend(FdProbeBackend backend) async {
+    final Object? raw = await methodChannel.invokeMethod(
+      'setFdProbeBackend',
+      <String, Object?>{'backend': backend.wireName},
+    );
+    return FdProbeBackend.fromWireName(raw) ?? FdProbeBackend.syscalls;
+  }
+
+  @override
+  Future<void> setFdConsistencyMode(FdConsistencyMode mode) async {
+    await methodChannel.invokeMethod<void>(
+      'setFdConsistencyMode',
+      <String, Object?>{'mode': mode.wireName},
+    );
+  }
+
+  @override
+  Future<void> enableEmergencyFdDump(
+    String path, {
+    int? triggerSignal,
+    bool dumpOnFatalSignal = true,
+    bool dumpOnEmfile = true,
+  }) async {
+    await methodChannel.invokeMethod<void>(
+      'enableEmergencyFdDump',
+      <String, Object?>{
+        'path': path,
+        'triggerSignal': triggerSignal,
+        'dumpOnFatalSignal': dumpOnFatalSignal,
+        'dumpOnEmfile': dumpOnEmfile,
+      },
+    );
+  }
+
+  @override
+  Future<void> disableEmergencyFdDump() async {
+    await methodChannel.invokeMethod<void>('disableEmergencyFdDump');
+  }
+
+  @override
+  Future<int> triggerEmergencyFdDump() async {
+    final Object? raw = await methodChannel.invokeMethod('triggerEmergencyFdDump');
+    if (raw is int) return raw;
+    if (raw is num) return raw.toInt();
+    return 0;
+  }
+
+  @override
+  Future<ShmPublisherInfo> enableShmPublisher({
+    String? name,
+    Duration interval = const Duration(seconds: 1),
+    int capacity = 4096,
+  }) async {
+    final Object? raw = await methodChannel.invokeMethod(
+      'enableShmPublisher',
+      <String, Object?>{
+        if (name != null) 'name': name,
+        'intervalMs': interval.inMilliseconds,
+        'capacity': capacity,
+      },
+    );
+    return ShmPublisherInfo.fromMap(raw is Map ? raw.cast<Object?, Object?>() : const <Object?, Object?>{});
+  }
+
+  @override
+  Future<void> disableShmPublisher() async {
+    await methodChannel.invokeMethod<void>('disableShmPublisher');
+  }
+
+  FdTraceInfo _traceInfo(Object? raw) {
+    return FdTraceInfo.fromMap(raw is Map ? raw.cast<Object?, Object?>() : const <Object?, Object?>{});
+  }
+
+  @override
+  Future<FdTraceInfo> startFdTrace(
+    String path, {
+    Duration interval = const Duration(seconds: 1),
+    int? maxBytes,
+  }) async {
+    final Object? raw = await methodChannel.invokeMethod(
+      'startFdTrace',
+      <String, Object?>{
+        'path': path,
+        'intervalMs': interval.inMilliseconds,
+        if (maxBytes != null) 'maxBytes': maxBytes,
+      },
+    );
+    return _traceInfo(raw);
+  }
+
+  @override
+  Future<FdTraceInfo> getFdTraceInfo() async {
+    return _traceInfo(await methodChannel.invokeMethod('getFdTraceInfo'));
+  }
+
+  @override
+  Future<FdTraceInfo> stopFdTrace() async {
+    return _traceInfo(await methodChannel.invokeMethod('stopFdTrace'));
+  }
 }
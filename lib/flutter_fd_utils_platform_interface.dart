@@ -1,9 +1,20 @@
+import 'dart:typed_data';
+
 import 'package:plugin_platform_interface/plugin_platform_interface.dart';
 
 import 'flutter_fd_utils_method_channel.dart';
+import 'src/collector_stats.dart';
+import 'src/file_usage.dart';
+import 'src/fd_collection.dart';
 import 'src/fd_info.dart';
+import 'src/fd_pressure.dart';
+import 'src/fd_range_result.dart';
+import 'src/fd_snapshot.dart';
+import 'src/fd_trace.dart';
 import 'src/nofile_limit.dart';
 import 'src/nofile_limit_result.dart';
+import 'src/shm_publisher.dart';
+import 'src/unix_socket_peer.dart';
 
 abstract class FlutterFdUtilsPlatform extends PlatformInterface {
   /// Constructs a FlutterFdUtilsPlatform.
@@ -29,10 +40,22 @@ abstract class FlutterFdUtilsPlatform extends PlatformInterface {
   /// Returns a human-readable report of the current process file descriptors.
   ///
   /// On unsupported platforms this may throw a [PlatformException] / [MissingPluginException].
-  Future<String> getFdReport() {
+  ///
+  /// If [maxAge] is given, a cached snapshot up to that age may be reused.
+  /// A [budget] or [cancelToken] forces a fresh, bounded collection.
+  Future<String> getFdReport({
+    Duration? maxAge,
+    FdCollectionBudget? budget,
+    FdCancellationToken? cancelToken,
+  }) {
     throw UnimplementedError('getFdReport() has not been implemented.');
   }
 
+  /// Streams the fd report as UTF-8 NDJSON in chunks of [chunkSize] bytes.
+  Stream<Uint8List> streamFdReportChunks({int chunkSize = 64 * 1024}) {
+    throw UnimplementedError('streamFdReportChunks() has not been implemented.');
+  }
+
   /// Returns the current process RLIMIT_NOFILE limits.
   Future<NofileLimit> getNofileLimit() {
     throw UnimplementedError('getNofileLimit() has not been implemented.');
@@ -48,13 +71,142 @@ abstract class FlutterFdUtilsPlatform extends PlatformInterface {
     throw UnimplementedError('getNofileHardLimit() has not been implemented.');
   }
 
+  /// Returns rolling latency histograms per collection phase and per method.
+  Future<FdCollectorStats> getCollectorStats({bool reset = false}) {
+    throw UnimplementedError('getCollectorStats() has not been implemented.');
+  }
+
+  /// Returns system-wide fd and watch limits next to this process's usage.
+  Future<FdPressure> getFdPressure() {
+    throw UnimplementedError('getFdPressure() has not been implemented.');
+  }
+
   /// Returns a structured list of current process file descriptors.
-  Future<List<FdInfo>> getFdList() {
+  ///
+  /// If [maxAge] is given, a cached snapshot up to that age may be reused.
+  Future<List<FdInfo>> getFdList({Duration? maxAge}) {
     throw UnimplementedError('getFdList() has not been implemented.');
   }
 
+  /// Returns the report, list and summary of a single collection.
+  Future<FdSnapshot> getFdSnapshot({Duration? maxAge}) {
+    throw UnimplementedError('getFdSnapshot() has not been implemented.');
+  }
+
   /// Attempts to update the soft RLIMIT_NOFILE (nofile) limit.
   Future<NofileLimitResult> setNofileSoftLimit(int softLimit, {bool clampToHardLimit = true}) {
     throw UnimplementedError('setNofileSoftLimit() has not been implemented.');
   }
+
+  /// Returns one page of the fd list, stopping early when [budget] runs out.
+  Future<FdListPage> getFdListPage({
+    FdCollectionBudget budget = const FdCollectionBudget(),
+    FdCancellationToken? cancelToken,
+  }) {
+    throw UnimplementedError('getFdListPage() has not been implemented.');
+  }
+
+  /// Cancels the collection started with [token], if it is still running.
+  Future<bool> cancelFdCollection(FdCancellationToken token) {
+    throw UnimplementedError('cancelFdCollection() has not been implemented.');
+  }
+
+  /// Joins open descriptors with the memory map to find open-only,
+  /// mapped-only and deleted files.
+  Future<FileUsageReport> getFileUsage() {
+    throw UnimplementedError('getFileUsage() has not been implemented.');
+  }
+
+  /// Resolves the processes on the other end of this process's unix sockets.
+  Future<UnixSocketPeerReport> getUnixSocketPeers({Duration? maxAge}) {
+    throw UnimplementedError('getUnixSocketPeers() has not been implemented.');
+  }
+
+  /// Sets FD_CLOEXEC on every open descriptor in [first]..[last].
+  Future<FdRangeResult> setCloexecRange(int first, [int? last]) {
+    throw UnimplementedError('setCloexecRange() has not been implemented.');
+  }
+
+  /// Closes every open descriptor in [first]..[last].
+  Future<FdRangeResult> closeRange(int first, [int? last]) {
+    throw UnimplementedError('closeRange() has not been implemented.');
+  }
+
+  /// Lists descriptors without FD_CLOEXEC, i.e. those inherited across exec.
+  Future<List<FdInfo>> getNonCloexecFds({bool includeStdio = false}) {
+    throw UnimplementedError('getNonCloexecFds() has not been implemented.');
+  }
+
+  /// Sets how old a cached snapshot may be when no explicit maxAge is passed.
+  Future<void> setSnapshotCacheMaxAge(Duration maxAge) {
+    throw UnimplementedError('setSnapshotCacheMaxAge() has not been implemented.');
+  }
+
+  /// Selects how collection passes probe descriptors and returns the backend
+  /// actually in effect.
+  Future<FdProbeBackend> setFdProbeBackend(FdProbeBackend backend) {
+    throw UnimplementedError('setFdProbeBackend() has not been implemented.');
+  }
+
+  /// Selects whether collection passes detect descriptors reused mid-probe.
+  Future<void> setFdConsistencyMode(FdConsistencyMode mode) {
+    throw UnimplementedError('setFdConsistencyMode() has not been implemented.');
+  }
+
+  /// Preallocates an emergency fd dumper that appends to [path].
+  ///
+  /// A compact snapshot is written when [triggerSignal] is delivered, before a
+  /// fatal signal terminates the process, and on the first EMFILE/ENFILE
+  /// observed by the plugin.
+  Future<void> enableEmergencyFdDump(
+    String path, {
+    int? triggerSignal,
+    bool dumpOnFatalSignal = true,
+    bool dumpOnEmfile = true,
+  }) {
+    throw UnimplementedError('enableEmergencyFdDump() has not been implemented.');
+  }
+
+  /// Removes the emergency fd dumper and restores previous signal handlers.
+  Future<void> disableEmergencyFdDump() {
+    throw UnimplementedError('disableEmergencyFdDump() has not been implemented.');
+  }
+
+  /// Writes an emergency fd dump now and returns the number of bytes written.
+  Future<int> triggerEmergencyFdDump() {
+    throw UnimplementedError('triggerEmergencyFdDump() has not been implemented.');
+  }
+
+  /// Starts publishing fd stats into a shared-memory segment.
+  Future<ShmPublisherInfo> enableShmPublisher({
+    String? name,
+    Duration interval = const Duration(seconds: 1),
+    int capacity = 4096,
+  }) {
+    throw UnimplementedError('enableShmPublisher() has not been implemented.');
+  }
+
+  /// Stops the shared-memory publisher.
+  Future<void> disableShmPublisher() {
+    throw UnimplementedError('disableShmPublisher() has not been implemented.');
+  }
+
+  /// Starts recording sampled fd counters and lifetimes as a trace file.
+  Future<FdTraceInfo> startFdTrace(
+    String path, {
+    Duration interval = const Duration(seconds: 1),
+    int? maxBytes,
+  }) {
+    throw UnimplementedError('startFdTrace() has not been implemented.');
+  }
+
+  /// Returns the progress of the running trace.
+  Future<FdTraceInfo> getFdTraceInfo() {
+    throw UnimplementedError('getFdTraceInfo() has not been implemented.');
+  }
+
+  /// Finishes the trace file.
+  Future<FdTraceInfo> stopFdTrace() {
+    throw UnimplementedError('stopFdTrace() has not been implemented.');
+  }
 }
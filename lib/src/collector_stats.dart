@@ -0,0 +1,155 @@
+/// A timed phase of fd collection or response building (Linux).
+enum FdPhase {
+  /// Reading `/proc/self/fd`.
+  dirScan('dir_scan'),
+
+  /// `fstat` of each descriptor.
+  fstat('fstat'),
+
+  /// `F_GETFL` / `F_GETFD`.
+  fcntl('fcntl'),
+
+  /// Resolving `/proc/self/fd/N` targets.
+  readlink('readlink'),
+
+  /// Socket option and address queries.
+  socketProbe('socket_probe'),
+
+  /// Encoding entries for the method channel.
+  encode('encode'),
+
+  /// Rendering the text or NDJSON report.
+  format('format');
+
+  const FdPhase(this.wireName);
+
+  /// Name used by the platform side.
+  final String wireName;
+
+  static FdPhase? fromWireName(Object? name) {
+    for (final FdPhase phase in values) {
+      if (phase.wireName == name) return phase;
+    }
+    return null;
+  }
+}
+
+Duration _nanos(Object? value) => Duration(microseconds: value is num ? value.toInt() ~/ 1000 : 0);
+
+/// Time spent in each phase of one collection. Phases that did not run are
+/// absent.
+class FdPhaseTimings {
+  const FdPhaseTimings(this.phases);
+
+  final Map<FdPhase, Duration> phases;
+
+  Duration operator [](FdPhase phase) => phases[phase] ?? Duration.zero;
+
+  static FdPhaseTimings fromMap(Object? raw) {
+    final Map<FdPhase, Duration> phases = <FdPhase, Duration>{};
+    if (raw is Map) {
+      raw.forEach((Object? key, Object? value) {
+        final FdPhase? phase = FdPhase.fromWireName(key);
+        if (phase != null) phases[phase] = _nanos(value);
+      });
+    }
+    return FdPhaseTimings(phases);
+  }
+}
+
+/// One histogram bucket: [count] samples at or below [upperBound].
+class FdLatencyBucket {
+  const FdLatencyBucket({required this.upperBound, required this.count});
+
+  final Duration upperBound;
+  final int count;
+}
+
+/// Log-linear latency histogram over the stats window. Percentiles are
+/// bucket upper bounds, accurate to about 6%.
+class FdLatencyHistogram {
+  const FdLatencyHistogram({
+    required this.count,
+    required this.min,
+    required this.max,
+    required this.mean,
+    required this.p50,
+    required this.p90,
+    required this.p99,
+    required this.p999,
+    this.buckets = const <FdLatencyBucket>[],
+  });
+
+  final int count;
+  final Duration min;
+  final Duration max;
+  final Duration mean;
+  final Duration p50;
+  final Duration p90;
+  final Duration p99;
+  final Duration p999;
+
+  /// Non-empty buckets in ascending order.
+  final List<FdLatencyBucket> buckets;
+
+  static FdLatencyHistogram fromMap(Object? raw) {
+    final Map<Object?, Object?> map = raw is Map ? raw.cast<Object?, Object?>() : const <Object?, Object?>{};
+    final Object? count = map['count'];
+    final Object? rawBuckets = map['buckets'];
+    return FdLatencyHistogram(
+      count: count is num ? count.toInt() : 0,
+      min: _nanos(map['minNs']),
+      max: _nanos(map['maxNs']),
+      mean: _nanos(map['meanNs']),
+      p50: _nanos(map['p50Ns']),
+      p90: _nanos(map['p90Ns']),
+      p99: _nanos(map['p99Ns']),
+      p999: _nanos(map['p999Ns']),
+      buckets: rawBuckets is List
+          ? rawBuckets
+              .whereType<List>()
+              .where((b) => b.length == 2 && b[1] is num)
+              .map((b) => FdLatencyBucket(upperBound: _nanos(b[0]), count: (b[1] as num).toInt()))
+              .toList(growable: false)
+          : const <FdLatencyBucket>[],
+    );
+  }
+}
+
+/// Rolling latency histograms per collection phase and per method (Linux).
+class FdCollectorStats {
+  const FdCollectorStats({required this.window, required this.phases, required this.methods});
+
+  /// How far back the histograms reach.
+  final Duration window;
+
+  /// One sample per collection (or response) per phase.
+  final Map<FdPhase, FdLatencyHistogram> phases;
+
+  /// End-to-end native handling time keyed by method name.
+  final Map<String, FdLatencyHistogram> methods;
+
+  static FdCollectorStats fromMap(Map<Object?, Object?> map) {
+    final Object? windowMs = map['windowMs'];
+    final Map<FdPhase, FdLatencyHistogram> phases = <FdPhase, FdLatencyHistogram>{};
+    final Object? rawPhases = map['phases'];
+    if (rawPhases is Map) {
+      rawPhases.forEach((Object? key, Object? value) {
+        final FdPhase? phase = FdPhase.fromWireName(key);
+        if (phase != null) phases[phase] = FdLatencyHistogram.fromMap(value);
+      });
+    }
+    final Map<String, FdLatencyHistogram> methods = <String, FdLatencyHistogram>{};
+    final Object? rawMethods = map['methods'];
+    if (rawMethods is Map) {
+      rawMethods.forEach((Object? key, Object? value) {
+        if (key is String) methods[key] = FdLatencyHistogram.fromMap(value);
+      });
+    }
+    return FdCollectorStats(
+      window: Duration(milliseconds: windowMs is num ? windowMs.toInt() : 0),
+      phases: phases,
+      methods: methods,
+    );
+  }
+}
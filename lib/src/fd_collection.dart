@@ -0,0 +1,124 @@
+import 'dart:math';
+
+import 'collector_stats.dart';
+import 'fd_info.dart';
+
+/// Limits for a single native collection pass.
+///
+/// When a budget runs out the pass stops early and reports where it stopped,
+/// so a follow-up call with [startFd] set to that cursor can continue.
+class FdCollectionBudget {
+  const FdCollectionBudget({this.timeBudget, this.maxProbes, this.startFd = 0});
+
+  /// Wall-clock time the collector may spend probing descriptors.
+  final Duration? timeBudget;
+
+  /// Maximum number of descriptors to probe.
+  final int? maxProbes;
+
+  /// First descriptor to probe; use [FdListPage.nextFd] to resume.
+  final int startFd;
+
+  Map<String, Object?> toArguments() {
+    return <String, Object?>{
+      'startFd': startFd,
+      if (timeBudget != null) 'timeBudgetMs': timeBudget!.inMilliseconds,
+      if (maxProbes != null) 'maxProbes': maxProbes,
+    };
+  }
+}
+
+/// How the native collector gets each descriptor's stat and flags.
+enum FdProbeBackend {
+  /// One `fstat` and two `fcntl` calls per descriptor.
+  syscalls('syscalls'),
+
+  /// Batched `statx` and fdinfo reads through io_uring.
+  ioUring('io_uring');
+
+  const FdProbeBackend(this.wireName);
+
+  /// Name used by the platform side.
+  final String wireName;
+
+  static FdProbeBackend? fromWireName(Object? name) {
+    for (final FdProbeBackend backend in values) {
+      if (backend.wireName == name) return backend;
+    }
+    return null;
+  }
+}
+
+/// Whether the native collector checks that a descriptor still refers to the
+/// same object (dev, inode) after probing it.
+///
+/// Without the check, a descriptor that another thread closes and reuses while
+/// it is being probed yields an entry mixing attributes of both objects.
+enum FdConsistencyMode {
+  /// No check (the default).
+  off('off'),
+
+  /// Flag such entries with [FdInfo.torn].
+  mark('mark'),
+
+  /// Probe such descriptors again a few times before flagging them; ones
+  /// closed for good are left out.
+  retry('retry');
+
+  const FdConsistencyMode(this.wireName);
+
+  /// Name used by the platform side.
+  final String wireName;
+}
+
+/// Identifies an in-flight collection so it can be cancelled.
+///
+/// Pass the same token to a collecting call and to
+/// `FlutterFdUtils.cancelFdCollection`.
+class FdCancellationToken {
+  FdCancellationToken() : id = _isolateSalt | (_nextId++ & 0xfffff);
+
+  // The native side keys requests by id across the whole process, while this
+  // counter is per isolate; the random high bits keep isolates apart.
+  static final int _isolateSalt = Random.secure().nextInt(1 << 32) << 20;
+  static int _nextId = 1;
+
+  final int id;
+}
+
+/// One page of a possibly truncated fd list.
+class FdListPage {
+  const FdListPage({
+    required this.entries,
+    required this.truncated,
+    this.nextFd,
+    this.timings = const FdPhaseTimings(<FdPhase, Duration>{}),
+  });
+
+  final List<FdInfo> entries;
+
+  /// Whether the collector stopped before the end of the fd table.
+  final bool truncated;
+
+  /// Resume cursor for the next page when [truncated].
+  final int? nextFd;
+
+  /// Where the native side spent its time producing this page.
+  final FdPhaseTimings timings;
+
+  static FdListPage fromMap(Map<Object?, Object?> map) {
+    final Object? rawEntries = map['entries'];
+    final Object? rawNextFd = map['nextFd'];
+    return FdListPage(
+      entries: rawEntries is List
+          ? rawEntries
+              .whereType<Map>()
+              .map((m) => FdInfo.fromMap(m.cast<Object?, Object?>()))
+              .toList(growable: false)
+          : const <FdInfo>[],
+      truncated: map['truncated'] == true,
+      nextFd: rawNextFd is num ? rawNextFd.toInt() : null,
+      timings: FdPhaseTimings.fromMap(map['timings']),
+    );
+  }
+}
@@ -7,6 +7,9 @@ class FdInfo {
     this.openFlags,
     this.fdFlags,
     this.path,
+    this.dev,
+    this.inode,
+    this.torn = false,
     this.socket,
     this.vnode,
   });
@@ -22,6 +25,16 @@ class FdInfo {
   final int? fdFlags;
 
   final String? path;
+
+  /// `st_dev` / `st_ino` of the open object (Linux).
+  final int? dev;
+  final int? inode;
+
+  /// The descriptor was closed or reused for another object while it was
+  /// being probed, so the fields may describe two different objects. Only
+  /// detected with `FlutterFdUtils.setFdConsistencyMode` (Linux).
+  final bool torn;
+
   final SocketInfo? socket;
   final VnodeInfo? vnode;
 
@@ -72,6 +85,9 @@ class FdInfo {
       openFlags: readNullableInt('openFlags'),
       fdFlags: readNullableInt('fdFlags'),
       path: readNullableString('path'),
+      dev: readNullableInt('dev'),
+      inode: readNullableInt('inode'),
+      torn: map['torn'] == true,
       socket: socket,
       vnode: vnode,
     );
@@ -126,11 +142,33 @@ class SocketInfo {
 }
 
 class VnodeInfo {
-  const VnodeInfo({required this.mode, required this.size});
+  const VnodeInfo({
+    required this.mode,
+    required this.size,
+    this.nlink,
+    this.diskBytes,
+    this.deleted = false,
+    this.mapped = false,
+    this.mappedBytes,
+  });
 
   final int mode;
   final int size;
 
+  /// Hard link count; 0 for a deleted file that is still open (Linux).
+  final int? nlink;
+
+  /// Space allocated on disk (Linux).
+  final int? diskBytes;
+
+  /// Whether the file was unlinked while still open (Linux).
+  final bool deleted;
+
+  /// Whether the file is also mapped into memory (Linux). Set by `getFdList`,
+  /// `getFdSnapshot` and `getFileUsage`; budgeted pages leave it false.
+  final bool mapped;
+  final int? mappedBytes;
+
   static VnodeInfo fromMap(Map<Object?, Object?> map) {
     int readInt(String key) {
       final Object? value = map[key];
@@ -139,9 +177,20 @@ class VnodeInfo {
       return 0;
     }
 
+    int? readNullableInt(String key) {
+      final Object? value = map[key];
+      if (value is num) return value.toInt();
+      return null;
+    }
+
     return VnodeInfo(
       mode: readInt('mode'),
       size: readInt('size'),
+      nlink: readNullableInt('nlink'),
+      diskBytes: readNullableInt('diskBytes'),
+      deleted: map['deleted'] == true,
+      mapped: map['mapped'] == true,
+      mappedBytes: readNullableInt('mappedBytes'),
     );
   }
 }
@@ -0,0 +1,76 @@
+/// Usage of one limited resource next to its limit.
+class FdPressureGauge {
+  const FdPressureGauge({this.used, this.limit, this.headroom});
+
+  /// Current usage, or null if it could not be read.
+  final int? used;
+
+  /// Limit the usage counts against, or null if it could not be read.
+  final int? limit;
+
+  /// `1 - used / limit` clamped to `[0, 1]`; null when either side is unknown.
+  final double? headroom;
+
+  static FdPressureGauge fromMap(Object? raw) {
+    if (raw is! Map) return const FdPressureGauge();
+    final Object? used = raw['used'];
+    final Object? limit = raw['limit'];
+    final Object? headroom = raw['headroom'];
+    return FdPressureGauge(
+      used: used is num ? used.toInt() : null,
+      limit: limit is num ? limit.toInt() : null,
+      headroom: headroom is num ? headroom.toDouble() : null,
+    );
+  }
+}
+
+/// System-wide fd and watch limits alongside this process's usage (Linux).
+///
+/// inotify and epoll limits are per user, so the process usage shown against
+/// them is a lower bound.
+class FdPressure {
+  const FdPressure({
+    required this.processFds,
+    this.nofileHard,
+    required this.systemFiles,
+    required this.inotifyInstances,
+    required this.inotifyWatches,
+    required this.epollInstances,
+    required this.epollWatches,
+  });
+
+  /// Open descriptors against the RLIMIT_NOFILE soft limit.
+  final FdPressureGauge processFds;
+
+  /// RLIMIT_NOFILE hard limit.
+  final int? nofileHard;
+
+  /// Allocated file handles against `fs.file-max` (`/proc/sys/fs/file-nr`).
+  final FdPressureGauge systemFiles;
+
+  /// inotify instances against `fs.inotify.max_user_instances`.
+  final FdPressureGauge inotifyInstances;
+
+  /// inotify watches against `fs.inotify.max_user_watches`.
+  final FdPressureGauge inotifyWatches;
+
+  /// epoll instances held by this process.
+  final int epollInstances;
+
+  /// epoll watches against `fs.epoll.max_user_watches`.
+  final FdPressureGauge epollWatches;
+
+  static FdPressure fromMap(Map<Object?, Object?> map) {
+    final Object? nofileHard = map['nofileHard'];
+    final Object? epollInstances = map['epollInstances'];
+    return FdPressure(
+      processFds: FdPressureGauge.fromMap(map['processFds']),
+      nofileHard: nofileHard is num ? nofileHard.toInt() : null,
+      systemFiles: FdPressureGauge.fromMap(map['systemFiles']),
+      inotifyInstances: FdPressureGauge.fromMap(map['inotifyInstances']),
+      inotifyWatches: FdPressureGauge.fromMap(map['inotifyWatches']),
+      epollInstances: epollInstances is num ? epollInstances.toInt() : 0,
+      epollWatches: FdPressureGauge.fromMap(map['epollWatches']),
+    );
+  }
+}
@@ -0,0 +1,37 @@
+/// Result of a bulk fd-table operation (`setCloexecRange` / `closeRange`).
+class FdRangeResult {
+  const FdRangeResult({
+    required this.success,
+    required this.usedCloseRange,
+    this.affected,
+    required this.errno,
+    required this.errorMessage,
+  });
+
+  /// Whether the call succeeded.
+  final bool success;
+
+  /// Whether the kernel's close_range(2) handled the whole range.
+  final bool usedCloseRange;
+
+  /// Descriptors changed by the fallback loop; null when close_range was used.
+  final int? affected;
+
+  /// errno value when failed, or 0.
+  final int errno;
+
+  /// strerror(errno) when failed, or empty.
+  final String errorMessage;
+
+  static FdRangeResult fromMap(Map<Object?, Object?> map) {
+    final Object? affected = map['affected'];
+    final Object? errno = map['errno'];
+    return FdRangeResult(
+      success: map['success'] == true,
+      usedCloseRange: map['usedCloseRange'] == true,
+      affected: affected is num ? affected.toInt() : null,
+      errno: errno is num ? errno.toInt() : 0,
+      errorMessage: map['errorMessage']?.toString() ?? '',
+    );
+  }
+}
@@ -18,6 +18,7 @@ class FdReportDialog extends StatefulWidget {
     this.copyText = 'Copy',
     this.closeText = 'Close',
     this.onCopied,
+    this.budget,
   });
 
   /// The API instance used to fetch the report.
@@ -35,6 +36,10 @@ class FdReportDialog extends StatefulWidget {
   /// If not provided, a SnackBar will be shown when possible.
   final VoidCallback? onCopied;
 
+  /// Optional limit for each refresh; large fd tables then show a partial
+  /// report instead of blocking the dialog.
+  final FdCollectionBudget? budget;
+
   /// Shows the dialog via [showDialog].
   static Future<void> show(
     BuildContext context, {
@@ -44,6 +49,7 @@ class FdReportDialog extends StatefulWidget {
     String copyText = 'Copy',
     String closeText = 'Close',
     VoidCallback? onCopied,
+    FdCollectionBudget? budget,
   }) {
     return showDialog<void>(
       context: context,
@@ -54,6 +60,7 @@ class FdReportDialog extends StatefulWidget {
         copyText: copyText,
         closeText: closeText,
         onCopied: onCopied,
+        budget: budget,
       ),
     );
   }
@@ -64,6 +71,7 @@ class FdReportDialog extends StatefulWidget {
 
 class _FdReportDialogState extends State<FdReportDialog> {
   Timer? _timer;
+  FdCancellationToken? _inFlight;
   String _report = '';
   bool _loading = true;
 
@@ -78,22 +86,40 @@ class _FdReportDialogState extends State<FdReportDialog> {
   void dispose() {
     _timer?.cancel();
     _timer = null;
+    final inFlight = _inFlight;
+    _inFlight = null;
+    if (inFlight != null && widget.budget != null) {
+      // The result is no longer wanted; stop the native collection early.
+      // Unbudgeted refreshes share the snapshot cache and run to completion.
+      unawaited(widget.api.cancelFdCollection(inFlight).catchError((Object _) => false));
+    }
     super.dispose();
   }
 
   Future<void> _refresh() async {
+    if (_inFlight != null) {
+      // The previous refresh is still collecting; skip this tick.
+      return;
+    }
+    final token = FdCancellationToken();
+    _inFlight = token;
+
     String nextReport;
     try {
-      nextReport = await widget.api.getFdReport();
+      nextReport = await widget.api.getFdReport(
+        budget: widget.budget,
+        cancelToken: widget.budget != null ? token : null,
+      );
     } on PlatformException catch (e) {
       nextReport = 'PlatformException: ${e.code}\n${e.message ?? ''}\n${e.details ?? ''}';
     } catch (e) {
       nextReport = 'Error: $e';
     }
 
-    if (!mounted) {
+    if (!mounted || _inFlight != token) {
       return;
     }
+    _inFlight = null;
 
     setState(() {
       _loading = false;
@@ -0,0 +1,40 @@
+import 'collector_stats.dart';
+import 'fd_info.dart';
+import 'fd_summary.dart';
+
+/// The text report, structured list and summary of a single collection.
+class FdSnapshot {
+  const FdSnapshot({
+    required this.report,
+    required this.entries,
+    required this.summary,
+    this.timings = const FdPhaseTimings(<FdPhase, Duration>{}),
+  });
+
+  /// Same format as `getFdReport()`.
+  final String report;
+
+  /// Same entries as `getFdList()`, in the same order as [report].
+  final List<FdInfo> entries;
+
+  final FdSummary summary;
+
+  /// Where the native side spent its time, including encoding both views.
+  final FdPhaseTimings timings;
+
+  static FdSnapshot fromMap(Map<Object?, Object?> map) {
+    final Object? rawEntries = map['entries'];
+    final Object? rawSummary = map['summary'];
+    return FdSnapshot(
+      report: map['report']?.toString() ?? '',
+      entries: rawEntries is List
+          ? rawEntries
+              .whereType<Map>()
+              .map((m) => FdInfo.fromMap(m.cast<Object?, Object?>()))
+              .toList(growable: false)
+          : const <FdInfo>[],
+      summary: FdSummary.fromMap(rawSummary is Map ? rawSummary.cast<Object?, Object?>() : const <Object?, Object?>{}),
+      timings: FdPhaseTimings.fromMap(map['timings']),
+    );
+  }
+}
@@ -0,0 +1,47 @@
+import 'nofile_limit.dart';
+
+/// Aggregate counts taken from one native snapshot.
+class FdSummary {
+  const FdSummary({
+    required this.fdCount,
+    required this.vnodeCount,
+    required this.socketCount,
+    required this.pipeCount,
+    required this.unknownCount,
+    required this.nonCloexecCount,
+    required this.limit,
+    required this.snapshotAge,
+  });
+
+  final int fdCount;
+  final int vnodeCount;
+  final int socketCount;
+  final int pipeCount;
+  final int unknownCount;
+
+  /// Descriptors without FD_CLOEXEC, i.e. inherited by exec'd children.
+  final int nonCloexecCount;
+
+  final NofileLimit limit;
+
+  /// How old the native snapshot was when the summary was read.
+  final Duration snapshotAge;
+
+  static FdSummary fromMap(Map<Object?, Object?> map) {
+    int readInt(String key) {
+      final Object? value = map[key];
+      return value is num ? value.toInt() : 0;
+    }
+
+    return FdSummary(
+      fdCount: readInt('fdCount'),
+      vnodeCount: readInt('vnodeCount'),
+      socketCount: readInt('socketCount'),
+      pipeCount: readInt('pipeCount'),
+      unknownCount: readInt('unknownCount'),
+      nonCloexecCount: readInt('nonCloexecCount'),
+      limit: NofileLimit(soft: readInt('nofileSoft'), hard: readInt('nofileHard')),
+      snapshotAge: Duration(microseconds: readInt('snapshotAgeUs')),
+    );
+  }
+}
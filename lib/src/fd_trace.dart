@@ -0,0 +1,62 @@
+/// State of the fd trace recorder (Linux).
+///
+/// The trace is Chrome trace-event JSON; open it in `chrome://tracing` or
+/// https://ui.perfetto.dev.
+class FdTraceInfo {
+  const FdTraceInfo({
+    required this.active,
+    required this.path,
+    required this.interval,
+    required this.maxBytes,
+    required this.bytesWritten,
+    required this.samples,
+    required this.opened,
+    required this.closed,
+    required this.truncated,
+    required this.writeErrno,
+  });
+
+  /// Whether samples are still being written.
+  final bool active;
+
+  final String path;
+
+  /// How often the fd table is sampled.
+  final Duration interval;
+
+  /// Size at which recording stops; 0 for no limit.
+  final int maxBytes;
+
+  final int bytesWritten;
+  final int samples;
+
+  /// Descriptor lifetimes begun and ended in the trace so far.
+  final int opened;
+  final int closed;
+
+  /// Recording stopped because [maxBytes] was reached.
+  final bool truncated;
+
+  /// errno of a failed write (which also stops recording), or 0.
+  final int writeErrno;
+
+  static FdTraceInfo fromMap(Map<Object?, Object?> map) {
+    int readInt(String key) {
+      final Object? value = map[key];
+      return value is num ? value.toInt() : 0;
+    }
+
+    return FdTraceInfo(
+      active: map['active'] == true,
+      path: map['path']?.toString() ?? '',
+      interval: Duration(milliseconds: readInt('intervalMs')),
+      maxBytes: readInt('maxBytes'),
+      bytesWritten: readInt('bytesWritten'),
+      samples: readInt('samples'),
+      opened: readInt('opened'),
+      closed: readInt('closed'),
+      truncated: map['truncated'] == true,
+      writeErrno: readInt('writeErrno'),
+    );
+  }
+}
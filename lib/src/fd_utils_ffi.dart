@@ -0,0 +1,202 @@
+import 'dart:ffi';
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:ffi/ffi.dart';
+
+import 'fd_summary.dart';
+import 'nofile_limit.dart';
+
+typedef _AbiVersionNative = Int32 Function();
+typedef _AbiVersion = int Function();
+typedef _FdCountNative = Int64 Function();
+typedef _FdCount = int Function();
+typedef _NofileLimitNative = Int32 Function(Pointer<Int64>, Pointer<Int64>);
+typedef _NofileLimit = int Function(Pointer<Int64>, Pointer<Int64>);
+typedef _SummaryNative = Int32 Function(Int64, Pointer<Int64>);
+typedef _Summary = int Function(int, Pointer<Int64>);
+typedef _SnapshotNative = Int64 Function(
+    Int64, Pointer<Int32>, Pointer<Int32>, Pointer<Int32>, Pointer<Int32>, Int64);
+typedef _Snapshot = int Function(
+    int, Pointer<Int32>, Pointer<Int32>, Pointer<Int32>, Pointer<Int32>, int);
+
+/// Must match FLUTTER_FD_UTILS_FFI_ABI_VERSION in flutter_fd_utils_ffi.h.
+const int _kAbiVersion = 1;
+
+/// Number of int64 fields in FlutterFdUtilsSummary.
+const int _kSummaryFields = 9;
+
+/// A snapshot in columnar form; row `i` of every column describes one fd.
+class FdColumnarSnapshot {
+  const FdColumnarSnapshot({
+    required this.fds,
+    required this.fdTypes,
+    required this.openFlags,
+    required this.fdFlags,
+  });
+
+  final Int32List fds;
+  final Int32List fdTypes;
+
+  /// Raw `fcntl(fd, F_GETFL)` values, or -1 when unavailable.
+  final Int32List openFlags;
+
+  /// Raw `fcntl(fd, F_GETFD)` values, or -1 when unavailable.
+  final Int32List fdFlags;
+
+  int get length => fds.length;
+}
+
+/// Synchronous bindings to the C ABI exported by the Linux plugin library.
+///
+/// Calls bypass the method channel entirely, so they can be made from any
+/// isolate without a round trip through the platform thread. [summary] and
+/// [snapshot] share the plugin's snapshot cache; when the cached snapshot is
+/// older than `maxAge` they block the calling isolate while a collection runs.
+/// Those two are bound as non-leaf calls so a long collection does not hold
+/// up garbage collection in the rest of the isolate group; only the O(1)
+/// getters are leaf calls.
+class FlutterFdUtilsFfi {
+  FlutterFdUtilsFfi._(DynamicLibrary lib)
+      : _fdCount = lib.lookupFunction<_FdCountNative, _FdCount>(
+          'flutter_fd_utils_get_fd_count',
+          isLeaf: true,
+        ),
+        _nofileLimit = lib.lookupFunction<_NofileLimitNative, _NofileLimit>(
+          'flutter_fd_utils_get_nofile_limit',
+          isLeaf: true,
+        ),
+        _summary = lib.lookupFunction<_SummaryNative, _Summary>(
+          'flutter_fd_utils_get_fd_summary',
+        ),
+        _snapshot = lib.lookupFunction<_SnapshotNative, _Snapshot>(
+          'flutter_fd_utils_get_fd_snapshot',
+        );
+
+  final _FdCount _fdCount;
+  final _NofileLimit _nofileLimit;
+  final _Summary _summary;
+  final _Snapshot _snapshot;
+
+  static FlutterFdUtilsFfi? _instance;
+  static bool _loaded = false;
+
+  /// The bindings, or null when the native library is unavailable (any
+  /// platform other than Linux, or an incompatible ABI version).
+  static FlutterFdUtilsFfi? get instance {
+    if (!_loaded) {
+      _loaded = true;
+      _instance = _load();
+    }
+    return _instance;
+  }
+
+  static FlutterFdUtilsFfi? _load() {
+    if (!Platform.isLinux) return null;
+    for (final DynamicLibrary Function() open in <DynamicLibrary Function()>[
+      () => DynamicLibrary.open('libflutter_fd_utils_plugin.so'),
+      // The runner links the plugin, so its symbols are already global.
+      () => DynamicLibrary.process(),
+    ]) {
+      try {
+        final lib = open();
+        final version = lib.lookupFunction<_AbiVersionNative, _AbiVersion>(
+          'flutter_fd_utils_ffi_abi_version',
+          isLeaf: true,
+        );
+        if (version() != _kAbiVersion) return null;
+        return FlutterFdUtilsFfi._(lib);
+      } on ArgumentError {
+        continue;
+      }
+    }
+    return null;
+  }
+
+  /// Number of open file descriptors; does not build a snapshot.
+  int fdCount() {
+    final count = _fdCount();
+    if (count < 0) {
+      throw OSError('fd count failed', -count);
+    }
+    return count;
+  }
+
+  /// Current RLIMIT_NOFILE limits.
+  NofileLimit nofileLimit() {
+    final soft = Int64List(1);
+    final hard = Int64List(1);
+    final err = _nofileLimit(soft.address, hard.address);
+    if (err != 0) {
+      throw OSError('getrlimit failed', err);
+    }
+    return NofileLimit(soft: soft[0], hard: hard[0]);
+  }
+
+  /// Aggregate counts from a snapshot no older than [maxAge] (the cache
+  /// default when null).
+  FdSummary summary({Duration? maxAge}) {
+    // Non-leaf calls cannot take typed-data addresses, which may move during
+    // the call; use native memory instead.
+    final out = calloc<Int64>(_kSummaryFields);
+    try {
+      final err = _summary(_maxAgeMs(maxAge), out);
+      if (err != 0) {
+        throw OSError('fd summary failed', err);
+      }
+      return FdSummary(
+        fdCount: out[0],
+        vnodeCount: out[1],
+        socketCount: out[2],
+        pipeCount: out[3],
+        unknownCount: out[4],
+        nonCloexecCount: out[5],
+        limit: NofileLimit(soft: out[6], hard: out[7]),
+        snapshotAge: Duration(microseconds: out[8]),
+      );
+    } finally {
+      calloc.free(out);
+    }
+  }
+
+  /// A columnar snapshot no older than [maxAge] (the cache default when null).
+  FdColumnarSnapshot snapshot({Duration? maxAge, int initialCapacity = 256}) {
+    var maxAgeMs = _maxAgeMs(maxAge);
+    var capacity = initialCapacity;
+    final elapsed = Stopwatch()..start();
+    while (true) {
+      final fds = calloc<Int32>(capacity);
+      final types = calloc<Int32>(capacity);
+      final openFlags = calloc<Int32>(capacity);
+      final fdFlags = calloc<Int32>(capacity);
+      try {
+        final total =
+            _snapshot(maxAgeMs, fds, types, openFlags, fdFlags, capacity);
+        if (total < 0) {
+          throw const OSError('fd snapshot failed');
+        }
+        if (total <= capacity) {
+          return FdColumnarSnapshot(
+            fds: Int32List.fromList(fds.asTypedList(total)),
+            fdTypes: Int32List.fromList(types.asTypedList(total)),
+            openFlags: Int32List.fromList(openFlags.asTypedList(total)),
+            fdFlags: Int32List.fromList(fdFlags.asTypedList(total)),
+          );
+        }
+        // Retry with room to spare. Any snapshot collected since the first
+        // call is young enough to reuse, so the retry does not start another
+        // collection that could have grown again.
+        capacity = total + total ~/ 8 + 16;
+        final sinceFirstCall = elapsed.elapsedMilliseconds + 1;
+        if (maxAgeMs < sinceFirstCall) maxAgeMs = sinceFirstCall;
+      } finally {
+        calloc.free(fds);
+        calloc.free(types);
+        calloc.free(openFlags);
+        calloc.free(fdFlags);
+      }
+    }
+  }
+
+  static int _maxAgeMs(Duration? maxAge) => maxAge == null ? -1 : maxAge.inMilliseconds;
+}
@@ -0,0 +1,131 @@
+/// How a file is held by the current process.
+enum FileUsageState {
+  /// Open through at least one descriptor, not mapped.
+  openOnly,
+
+  /// Mapped into memory with no open descriptor (e.g. mmapped then closed).
+  mappedOnly,
+
+  /// Both open and mapped.
+  openAndMapped,
+}
+
+/// A regular file held open and/or mapped by the current process.
+class FileUsage {
+  const FileUsage({
+    required this.dev,
+    required this.inode,
+    required this.path,
+    required this.state,
+    required this.deleted,
+    required this.fds,
+    required this.mappingCount,
+    required this.mappedBytes,
+    this.size,
+    this.diskBytes,
+    required this.reclaimableBytes,
+  });
+
+  final int dev;
+  final int inode;
+
+  /// Path as reported by the kernel, without the " (deleted)" suffix.
+  final String path;
+
+  final FileUsageState state;
+
+  /// Whether the file has been unlinked while still open or mapped.
+  final bool deleted;
+
+  /// Descriptors referring to the file.
+  final List<int> fds;
+
+  final int mappingCount;
+
+  /// Total length of the file's mappings.
+  final int mappedBytes;
+
+  /// File size, or null if the file could not be stat'ed.
+  final int? size;
+
+  /// Space allocated on disk, or null if the file could not be stat'ed.
+  final int? diskBytes;
+
+  /// Disk space freed once this process releases the file (deleted files
+  /// only).
+  final int reclaimableBytes;
+
+  static FileUsage fromMap(Map<Object?, Object?> map) {
+    int readInt(String key) {
+      final Object? value = map[key];
+      if (value is num) return value.toInt();
+      return 0;
+    }
+
+    int? readNullableInt(String key) {
+      final Object? value = map[key];
+      if (value is num) return value.toInt();
+      return null;
+    }
+
+    FileUsageState readState() {
+      switch (map['state']) {
+        case 'mapped':
+          return FileUsageState.mappedOnly;
+        case 'both':
+          return FileUsageState.openAndMapped;
+        default:
+          return FileUsageState.openOnly;
+      }
+    }
+
+    final Object? fds = map['fds'];
+    return FileUsage(
+      dev: readInt('dev'),
+      inode: readInt('inode'),
+      path: map['path']?.toString() ?? '',
+      state: readState(),
+      deleted: map['deleted'] == true,
+      fds: fds is List ? fds.whereType<num>().map((n) => n.toInt()).toList(growable: false) : const <int>[],
+      mappingCount: readInt('mappingCount'),
+      mappedBytes: readInt('mappedBytes'),
+      size: readNullableInt('size'),
+      diskBytes: readNullableInt('diskBytes'),
+      reclaimableBytes: readInt('reclaimableBytes'),
+    );
+  }
+}
+
+/// Open and mapped files of the current process, joined by (dev, inode).
+class FileUsageReport {
+  const FileUsageReport({
+    required this.files,
+    required this.deletedFileCount,
+    required this.deletedReclaimableBytes,
+  });
+
+  final List<FileUsage> files;
+
+  /// Number of deleted files still held open or mapped; memfds are not
+  /// counted.
+  final int deletedFileCount;
+
+  /// Disk space that would be freed if every deleted file were released.
+  final int deletedReclaimableBytes;
+
+  static FileUsageReport fromMap(Map<Object?, Object?> map) {
+    final Object? files = map['files'];
+    final Object? count = map['deletedFileCount'];
+    final Object? bytes = map['deletedReclaimableBytes'];
+    return FileUsageReport(
+      files: files is List
+          ? files
+              .whereType<Map>()
+              .map((m) => FileUsage.fromMap(m.cast<Object?, Object?>()))
+              .toList(growable: false)
+          : const <FileUsage>[],
+      deletedFileCount: count is num ? count.toInt() : 0,
+      deletedReclaimableBytes: bytes is num ? bytes.toInt() : 0,
+    );
+  }
+}
@@ -0,0 +1,44 @@
+/// Where the shared-memory fd publisher writes (Linux).
+///
+/// The segment layout and reader protocol are documented in
+/// `linux/include/flutter_fd_utils/flutter_fd_utils_shm.h`.
+class ShmPublisherInfo {
+  const ShmPublisherInfo({
+    required this.path,
+    required this.fd,
+    required this.segmentSize,
+    required this.capacity,
+    required this.interval,
+  });
+
+  /// Path an external reader should open and map read-only: `/dev/shm/<name>`
+  /// or `/proc/<pid>/fd/<n>` for an anonymous memfd.
+  final String path;
+
+  /// Descriptor of the segment in this process.
+  final int fd;
+
+  /// Total mapped size in bytes.
+  final int segmentSize;
+
+  /// Maximum number of fd entries in the segment.
+  final int capacity;
+
+  /// How often the background monitor refreshes the segment.
+  final Duration interval;
+
+  static ShmPublisherInfo fromMap(Map<Object?, Object?> map) {
+    int readInt(String key) {
+      final Object? value = map[key];
+      return value is num ? value.toInt() : 0;
+    }
+
+    return ShmPublisherInfo(
+      path: map['path']?.toString() ?? '',
+      fd: readInt('fd'),
+      segmentSize: readInt('segmentSize'),
+      capacity: readInt('capacity'),
+      interval: Duration(milliseconds: readInt('intervalMs')),
+    );
+  }
+}
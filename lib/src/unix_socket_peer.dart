@@ -0,0 +1,89 @@
+/// A unix-domain socket held by the current process and, when it is
+/// connected, the process holding the other end.
+class UnixSocketPeer {
+  const UnixSocketPeer({
+    required this.fd,
+    required this.inode,
+    required this.local,
+    this.peerInode,
+    this.peerPid,
+    this.peerFd,
+    this.peerComm,
+  });
+
+  final int fd;
+
+  /// Socket inode, as in `socket:[inode]`.
+  final int inode;
+
+  /// Local address, e.g. `unix:/run/app.sock`, `unix:@abstract` or
+  /// `unix:(anonymous)`.
+  final String local;
+
+  /// Inode of the peer socket, or null if the socket is not connected or
+  /// sock_diag is unavailable.
+  final int? peerInode;
+
+  /// Process holding the peer socket, or null if it could not be resolved
+  /// (e.g. the owner belongs to another user).
+  final int? peerPid;
+
+  /// Descriptor of the peer socket inside [peerPid].
+  final int? peerFd;
+
+  /// Command name of [peerPid] from `/proc/<pid>/comm`.
+  final String? peerComm;
+
+  static UnixSocketPeer fromMap(Map<Object?, Object?> map) {
+    int? readNullableInt(String key) {
+      final Object? value = map[key];
+      if (value is num) return value.toInt();
+      return null;
+    }
+
+    return UnixSocketPeer(
+      fd: readNullableInt('fd') ?? -1,
+      inode: readNullableInt('inode') ?? 0,
+      local: map['local']?.toString() ?? '',
+      peerInode: readNullableInt('peerInode'),
+      peerPid: readNullableInt('peerPid'),
+      peerFd: readNullableInt('peerFd'),
+      peerComm: map['peerComm']?.toString(),
+    );
+  }
+}
+
+/// Unix sockets of the current process with their resolved peers.
+class UnixSocketPeerReport {
+  const UnixSocketPeerReport({
+    required this.sockets,
+    required this.diagErrno,
+    required this.processesScanned,
+  });
+
+  final List<UnixSocketPeer> sockets;
+
+  /// errno of the sock_diag query, or 0 if it succeeded. When non-zero no
+  /// peers are resolved.
+  final int diagErrno;
+
+  /// Processes whose fd tables had to be scanned for this call; 0 when every
+  /// peer came from the inode index.
+  final int processesScanned;
+
+  static UnixSocketPeerReport fromMap(Map<Object?, Object?> map) {
+    final Object? sockets = map['sockets'];
+    final Object? diagErrno = map['diagErrno'];
+    final Object? scanned = map['processesScanned'];
+    return UnixSocketPeerReport(
+      sockets: sockets is List
+          ? sockets
+              .whereType<Map>()
+              .map((m) => UnixSocketPeer.fromMap(m.cast<Object?, Object?>()))
+              .toList(growable: false)
+          : const <UnixSocketPeer>[],
+      diagErrno: diagErrno is num ? diagErrno.toInt() : 0,
+      processesScanned: scanned is num ? scanned.toInt() : 0,
+    );
+  }
+}
@@ -0,0 +1,132 @@
+// Snapshots the fd table while several threads keep closing descriptors and
+// reopening different objects under the freed numbers, and reports snapshot
+// throughput, churn rate and how many entries each consistency mode found
+// torn (the descriptor changed identity while it was being probed).
+//
+// Usage: churn_benchmark [threads=4] [fds_per_thread=1000] [seconds=3]
+
+#include "fd_collector.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+std::atomic<bool> g_stop{false};
+// Threads that have opened their initial descriptors.
+std::atomic<int> g_ready{0};
+std::atomic<long long> g_churned{0};
+
+// Opens one object of a kind that depends on |n|; for pipes the write end is
+// closed right away so each slot holds exactly one descriptor.
+int OpenObject(unsigned n) {
+  switch (n % 3) {
+    case 0:
+      return open("/dev/null", O_RDONLY | O_CLOEXEC);
+    case 1: {
+      int p[2];
+      if (pipe2(p, O_CLOEXEC) != 0) return -1;
+      close(p[1]);
+      return p[0];
+    }
+    default:
+      return socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  }
+}
+
+void Churn(unsigned seed, int fds) {
+  std::vector<int> slots;
+  for (int i = 0; i < fds; i++) {
+    slots.push_back(OpenObject(seed + static_cast<unsigned>(i)));
+  }
+  g_ready.fetch_add(1);
+  unsigned n = seed;
+  long long local = 0;
+  while (!g_stop.load(std::memory_order_relaxed)) {
+    size_t i = (n * 2654435761u) % slots.size();
+    if (slots[i] >= 0) close(slots[i]);
+    slots[i] = OpenObject(++n);
+    if (++local == 256) {
+      g_churned.fetch_add(local, std::memory_order_relaxed);
+      local = 0;
+    }
+  }
+  g_churned.fetch_add(local, std::memory_order_relaxed);
+  for (int fd : slots) {
+    if (fd >= 0) close(fd);
+  }
+}
+
+void Run(const char* label, FdConsistencyMode mode, double seconds) {
+  FdCollectOptions options;
+  options.consistency = mode;
+  long long passes = 0;
+  long long entries = 0;
+  long long torn = 0;
+  long long retries = 0;
+  long long churn_start = g_churned.load();
+  auto start = std::chrono::steady_clock::now();
+  double elapsed = 0;
+  while (elapsed < seconds) {
+    FdCollectResult r = CollectFdList(options);
+    passes++;
+    entries += static_cast<long long>(r.entries.size());
+    torn += r.torn;
+    retries += r.retries;
+    elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  double churn_rate = (g_churned.load() - churn_start) / elapsed;
+  std::printf("%-7s passes/s=%7.1f entries/pass=%7.0f churn=%9.0f fds/s", label, passes / elapsed,
+              static_cast<double>(entries) / passes, churn_rate);
+  if (mode == FD_CONSISTENCY_OFF) {
+    std::printf(" torn=unchecked\n");
+  } else {
+    std::printf(" torn=%lld (%.1f per 1M entries) retries=%lld\n", torn, torn * 1e6 / std::max(1LL, entries),
+                retries);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int threads = argc > 1 ? std::max(1, std::atoi(argv[1])) : 4;
+  int fds_per_thread = argc > 2 ? std::max(1, std::atoi(argv[2])) : 1000;
+  double seconds = argc > 3 ? std::atof(argv[3]) : 3;
+
+  struct rlimit lim;
+  getrlimit(RLIMIT_NOFILE, &lim);
+  rlim_t wanted = static_cast<rlim_t>(threads) * fds_per_thread + 64;
+  if (lim.rlim_cur < wanted) {
+    lim.rlim_cur = std::min(wanted, lim.rlim_max);
+    setrlimit(RLIMIT_NOFILE, &lim);
+  }
+
+  std::printf("churn threads: %d, fds per thread: %d, seconds per mode: %.1f\n", threads, fds_per_thread, seconds);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back(Churn, static_cast<unsigned>(t) * 7919u, fds_per_thread);
+  }
+
+  while (g_ready.load() < threads) {
+    std::this_thread::yield();
+  }
+
+  Run("off", FD_CONSISTENCY_OFF, seconds);
+  Run("mark", FD_CONSISTENCY_MARK, seconds);
+  Run("retry", FD_CONSISTENCY_RETRY, seconds);
+
+  g_stop = true;
+  for (std::thread& w : workers) {
+    w.join();
+  }
+  return 0;
+}
@@ -0,0 +1,115 @@
+// Measures CollectFdList() with the syscall and io_uring probe backends over
+// large fd tables (a mix of regular files, pipes and sockets).
+//
+// Usage: collect_benchmark [fd_counts=10000,100000] [iterations=20]
+//
+// Each count is capped by the RLIMIT_NOFILE hard limit. Every backend gets
+// one untimed pass first, so the numbers are the steady state: the io_uring
+// prober is set up once per process and reused by later passes.
+
+#include "fd_collector.h"
+#include "fd_uring_probe.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// Opens descriptors until about |target| are open; returns the number open.
+int FillTable(int target, int open_now) {
+  while (open_now < target) {
+    int kind = open_now % 3;
+    if (kind == 0) {
+      if (open("/dev/null", O_RDONLY | O_CLOEXEC) < 0) break;
+      open_now++;
+    } else if (kind == 1) {
+      int p[2];
+      if (pipe2(p, O_CLOEXEC) != 0) break;
+      open_now += 2;
+    } else {
+      if (socket(AF_UNIX, SOCK_STREAM, 0) < 0) break;
+      open_now++;
+    }
+  }
+  return open_now;
+}
+
+struct Run {
+  std::vector<double> ms;
+  size_t entries = 0;
+  bool used_io_uring = false;
+  FdPhaseTimings timings;
+};
+
+Run Measure(FdProbeBackend backend, int iterations) {
+  Run run;
+  FdCollectOptions options;
+  options.backend = backend;
+  CollectFdList(options);
+  for (int i = 0; i < iterations; i++) {
+    auto start = std::chrono::steady_clock::now();
+    FdCollectResult r = CollectFdList(options);
+    run.ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    run.entries = r.entries.size();
+    run.used_io_uring = r.used_io_uring;
+    for (int p = 0; p < FD_PHASE_COUNT; p++) {
+      run.timings.ns[p] += r.timings.ns[p];
+    }
+  }
+  std::sort(run.ms.begin(), run.ms.end());
+  return run;
+}
+
+void Print(const char* label, const Run& run) {
+  double sum = 0;
+  for (double s : run.ms) sum += s;
+  auto pct = [&](double p) { return run.ms[static_cast<size_t>(p * (run.ms.size() - 1))]; };
+  double n = static_cast<double>(run.ms.size());
+  std::printf("  %-9s entries=%zu mean=%8.2fms p50=%8.2fms p99=%8.2fms | stat+flags=%7.2fms readlink=%7.2fms\n",
+              label, run.entries, sum / n, pct(0.5), pct(0.99),
+              (run.timings.ns[FD_PHASE_FSTAT] + run.timings.ns[FD_PHASE_FCNTL]) / 1e6 / n,
+              run.timings.ns[FD_PHASE_READLINK] / 1e6 / n);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::vector<int> counts;
+  std::string spec = argc > 1 ? argv[1] : "10000,100000";
+  for (size_t pos = 0; pos < spec.size();) {
+    size_t comma = spec.find(',', pos);
+    if (comma == std::string::npos) comma = spec.size();
+    counts.push_back(std::atoi(spec.substr(pos, comma - pos).c_str()));
+    pos = comma + 1;
+  }
+  int iterations = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20;
+
+  struct rlimit lim;
+  getrlimit(RLIMIT_NOFILE, &lim);
+  lim.rlim_cur = lim.rlim_max;
+  setrlimit(RLIMIT_NOFILE, &lim);
+  // Leave room for the collector's own descriptors and the ring.
+  int ceiling = static_cast<int>(std::min<rlim_t>(lim.rlim_max, 1 << 24)) - 16;
+
+  std::printf("io_uring available: %s, nofile hard limit: %llu, iterations: %d\n",
+              FdUringProber::Available() ? "yes" : "no", static_cast<unsigned long long>(lim.rlim_max), iterations);
+
+  int open_now = 3;
+  for (int count : counts) {
+    int target = std::min(count, ceiling);
+    open_now = FillTable(target, open_now);
+    std::printf("%d fds%s:\n", open_now, target < count ? " (capped)" : "");
+    Print("syscalls", Measure(FD_PROBE_SYSCALLS, iterations));
+    Run uring = Measure(FD_PROBE_IO_URING, iterations);
+    Print(uring.used_io_uring ? "io_uring" : "fallback", uring);
+  }
+  return 0;
+}
@@ -0,0 +1,754 @@
+#include "fd_collector.h"
+
+#include "fd_emergency_dump.h"
+#include "fd_entry_schema.h"
+#include "fd_table_ops.h"
+#include "fd_uring_probe.h"
+
+#include <algorithm>
+#include <chrono>
+#include <arpa/inet.h>
+#include <cstddef>
+#include <cstdlib>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <iomanip>
+#include <linux/tcp.h>
+#include <limits.h>
+#include <map>
+#include <memory>
+#include <netinet/in.h>
+#include <sys/un.h>
+#include <sstream>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <ctime>
+#include <unistd.h>
+
+std::string Iso8601Now() {
+  auto now = std::chrono::system_clock::now();
+  std::time_t tt = std::chrono::system_clock::to_time_t(now);
+  std::tm tm_utc{};
+  gmtime_r(&tt, &tm_utc);
+
+  std::ostringstream ss;
+  ss << std::put_time(&tm_utc, "%Y-%m-%dT%H:%M:%S");
+
+  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
+  ss << "." << std::setfill('0') << std::setw(3) << ms.count() << "Z";
+  return ss.str();
+}
+
+static std::string DescribeSockaddr(const struct sockaddr* addr, socklen_t len) {
+  if (addr == nullptr || len == 0) {
+    return "";
+  }
+
+  if (addr->sa_family == AF_INET) {
+    const struct sockaddr_in* in4 = reinterpret_cast<const struct sockaddr_in*>(addr);
+    char ip[INET_ADDRSTRLEN];
+    const char* p = inet_ntop(AF_INET, &in4->sin_addr, ip, sizeof(ip));
+    int port = ntohs(in4->sin_port);
+    if (p != nullptr) {
+      std::ostringstream ss;
+      ss << p << ":" << port;
+      return ss.str();
+    }
+    return "AF_INET:" + std::to_string(port);
+  }
+
+  if (addr->sa_family == AF_INET6) {
+    const struct sockaddr_in6* in6 = reinterpret_cast<const struct sockaddr_in6*>(addr);
+    char ip[INET6_ADDRSTRLEN];
+    const char* p = inet_ntop(AF_INET6, &in6->sin6_addr, ip, sizeof(ip));
+    int port = ntohs(in6->sin6_port);
+    if (p != nullptr) {
+      std::ostringstream ss;
+      ss << "[" << p << "]:" << port;
+      return ss.str();
+    }
+    return "AF_INET6:" + std::to_string(port);
+  }
+
+  if (addr->sa_family == AF_UNIX) {
+    // Unnamed sockets (socketpair, unbound clients) return only sun_family;
+    // abstract names start with a NUL and are not NUL-terminated.
+    const struct sockaddr_un* un = reinterpret_cast<const struct sockaddr_un*>(addr);
+    size_t path_len = len > offsetof(struct sockaddr_un, sun_path) ? len - offsetof(struct sockaddr_un, sun_path) : 0;
+    if (path_len == 0) {
+      return "unix:(anonymous)";
+    }
+    if (un->sun_path[0] == 0) {
+      return "unix:@" + std::string(un->sun_path + 1, path_len - 1);
+    }
+    return "unix:" + std::string(un->sun_path, strnlen(un->sun_path, path_len));
+  }
+
+  return std::string("family=") + std::to_string(addr->sa_family);
+}
+
+static std::string TcpStateName(int state) {
+#ifndef TCP_ESTABLISHED
+#define TCP_ESTABLISHED 1
+#define TCP_SYN_SENT 2
+#define TCP_SYN_RECV 3
+#define TCP_FIN_WAIT1 4
+#define TCP_FIN_WAIT2 5
+#define TCP_TIME_WAIT 6
+#define TCP_CLOSE 7
+#define TCP_CLOSE_WAIT 8
+#define TCP_LAST_ACK 9
+#define TCP_LISTEN 10
+#define TCP_CLOSING 11
+#endif
+  switch (state) {
+    case TCP_ESTABLISHED:
+      return "ESTABLISHED";
+    case TCP_SYN_SENT:
+      return "SYN_SENT";
+    case TCP_SYN_RECV:
+      return "SYN_RECV";
+    case TCP_FIN_WAIT1:
+      return "FIN_WAIT_1";
+    case TCP_FIN_WAIT2:
+      return "FIN_WAIT_2";
+    case TCP_TIME_WAIT:
+      return "TIME_WAIT";
+    case TCP_CLOSE:
+      return "CLOSED";
+    case TCP_CLOSE_WAIT:
+      return "CLOSE_WAIT";
+    case TCP_LAST_ACK:
+      return "LAST_ACK";
+    case TCP_LISTEN:
+      return "LISTEN";
+    case TCP_CLOSING:
+      return "CLOSING";
+    default:
+      return "UNKNOWN(" + std::to_string(state) + ")";
+  }
+}
+
+// Appends e.g. "RDWR|NONBLOCK"; nothing for a negative value.
+static void AppendOpenFlags(std::string* out, int fl) {
+  if (fl < 0) {
+    return;
+  }
+  size_t start = out->size();
+  auto add = [&](const char* name) {
+    if (out->size() > start) out->push_back('|');
+    out->append(name);
+  };
+  int acc = fl & O_ACCMODE;
+  if (acc == O_RDONLY) {
+    add("RDONLY");
+  } else if (acc == O_WRONLY) {
+    add("WRONLY");
+  } else if (acc == O_RDWR) {
+    add("RDWR");
+  }
+  if ((fl & O_NONBLOCK) != 0) {
+    add("NONBLOCK");
+  }
+  if ((fl & O_APPEND) != 0) {
+    add("APPEND");
+  }
+  if ((fl & O_SYNC) != 0) {
+    add("SYNC");
+  }
+}
+
+std::string OpenFlagsString(int fl) {
+  std::string out;
+  AppendOpenFlags(&out, fl);
+  return out;
+}
+
+std::string FdFlagsString(int flags) {
+  if (flags < 0) {
+    return "";
+  }
+  if ((flags & FD_CLOEXEC) != 0) {
+    return "CLOEXEC";
+  }
+  return "";
+}
+
+static std::string ReadFdPath(int fd) {
+  char linkname[PATH_MAX];
+  std::snprintf(linkname, sizeof(linkname), "/proc/self/fd/%d", fd);
+
+  char buf[PATH_MAX];
+  ssize_t len = readlink(linkname, buf, sizeof(buf) - 1);
+  if (len <= 0) {
+    return "";
+  }
+  buf[len] = '\0';
+  return std::string(buf);
+}
+
+const char* FdTypeName(int type) {
+  switch (type) {
+    case FD_TYPE_VNODE:
+      return "VNODE";
+    case FD_TYPE_SOCKET:
+      return "SOCKET";
+    case FD_TYPE_PIPE:
+      return "PIPE";
+    default:
+      return "UNKNOWN";
+  }
+}
+
+static SocketDetails BuildSocketDetails(int fd) {
+  SocketDetails s;
+
+  int so_type = 0;
+  socklen_t so_type_len = sizeof(so_type);
+  if (getsockopt(fd, SOL_SOCKET, SO_TYPE, &so_type, &so_type_len) == 0) {
+    s.has_so_type = true;
+    s.so_type = so_type;
+    s.present = true;
+  }
+
+  int so_proto = 0;
+  socklen_t so_proto_len = sizeof(so_proto);
+#ifdef SO_PROTOCOL
+  if (getsockopt(fd, SOL_SOCKET, SO_PROTOCOL, &so_proto, &so_proto_len) == 0) {
+    s.has_so_proto = true;
+    s.so_proto = so_proto;
+    s.present = true;
+  }
+#endif
+
+  struct sockaddr_storage laddr;
+  socklen_t laddr_len = sizeof(laddr);
+  if (getsockname(fd, reinterpret_cast<struct sockaddr*>(&laddr), &laddr_len) == 0) {
+    s.local = DescribeSockaddr(reinterpret_cast<struct sockaddr*>(&laddr), laddr_len);
+    s.family = reinterpret_cast<struct sockaddr*>(&laddr)->sa_family;
+    s.has_family = true;
+    s.present = true;
+  }
+
+  struct sockaddr_storage raddr;
+  socklen_t raddr_len = sizeof(raddr);
+  if (getpeername(fd, reinterpret_cast<struct sockaddr*>(&raddr), &raddr_len) == 0) {
+    s.peer = DescribeSockaddr(reinterpret_cast<struct sockaddr*>(&raddr), raddr_len);
+    if (!s.has_family) {
+      s.family = reinterpret_cast<struct sockaddr*>(&raddr)->sa_family;
+      s.has_family = true;
+    }
+    s.present = true;
+  }
+
+#ifdef TCP_INFO
+  struct tcp_info tcpi;
+  socklen_t tcpi_len = sizeof(tcpi);
+  if (getsockopt(fd, IPPROTO_TCP, TCP_INFO, &tcpi, &tcpi_len) == 0) {
+    s.has_tcp_state = true;
+    s.tcp_state = tcpi.tcpi_state;
+    s.tcp_state_name = TcpStateName(tcpi.tcpi_state);
+    s.present = true;
+  }
+#endif
+
+  return s;
+}
+
+static VnodeDetails BuildVnodeDetails(const struct stat& st) {
+  VnodeDetails v;
+  v.present = true;
+  v.mode = static_cast<int>(st.st_mode);
+  v.size = static_cast<long long>(st.st_size);
+  v.nlink = static_cast<long long>(st.st_nlink);
+  v.disk_bytes = static_cast<long long>(st.st_blocks) * 512;
+  v.deleted = S_ISREG(st.st_mode) && st.st_nlink == 0;
+  return v;
+}
+
+// Fills in everything of |e| that follows from the descriptor's stat: the
+// path, the type and the socket or vnode details. Continues the timing of
+// ProbeFd().
+static void FinishProbe(int fd, const struct stat& st, FdEntry* e, FdPhaseTimings* timings, long long* clock) {
+  e->fd = fd;
+  e->dev = static_cast<unsigned long long>(st.st_dev);
+  e->inode = static_cast<unsigned long long>(st.st_ino);
+
+  e->path = ReadFdPath(fd);
+  long long now = MonotonicNowNs();
+  timings->ns[FD_PHASE_READLINK] += now - *clock;
+  *clock = now;
+
+  if (S_ISSOCK(st.st_mode)) {
+    e->fd_type = FD_TYPE_SOCKET;
+    e->fd_type_name = FdTypeName(e->fd_type);
+    e->socket = BuildSocketDetails(fd);
+    now = MonotonicNowNs();
+    timings->ns[FD_PHASE_SOCKET_PROBE] += now - *clock;
+    *clock = now;
+  } else if (S_ISFIFO(st.st_mode)) {
+    e->fd_type = FD_TYPE_PIPE;
+    e->fd_type_name = FdTypeName(e->fd_type);
+  } else {
+    e->fd_type = FD_TYPE_VNODE;
+    e->fd_type_name = FdTypeName(e->fd_type);
+    e->vnode = BuildVnodeDetails(st);
+  }
+}
+
+// |clock| holds the time the probe starts and is advanced to the time it
+// ends, so consecutive phases share timestamps.
+static bool ProbeFd(int fd, FdEntry* e, FdPhaseTimings* timings, long long* clock) {
+  struct stat st;
+  int stat_ret = fstat(fd, &st);
+  long long now = MonotonicNowNs();
+  timings->ns[FD_PHASE_FSTAT] += now - *clock;
+  *clock = now;
+  if (stat_ret != 0) {
+    return false;
+  }
+
+  e->open_flags = fcntl(fd, F_GETFL);
+  e->fd_flags = fcntl(fd, F_GETFD);
+  now = MonotonicNowNs();
+  timings->ns[FD_PHASE_FCNTL] += now - *clock;
+  *clock = now;
+
+  FinishProbe(fd, st, e, timings, clock);
+  return true;
+}
+
+// Like ProbeFd(), from the stat and flags an FdUringProber batch returned.
+static bool ProbeFdFromUring(int fd, const FdUringResult& r, FdEntry* e, FdPhaseTimings* timings, long long* clock) {
+  if (!r.stat_ok) {
+    return ProbeFd(fd, e, timings, clock);
+  }
+  if (r.flags_ok) {
+    e->open_flags = r.open_flags;
+    e->fd_flags = r.fd_flags;
+  } else {
+    e->open_flags = fcntl(fd, F_GETFL);
+    e->fd_flags = fcntl(fd, F_GETFD);
+    long long now = MonotonicNowNs();
+    timings->ns[FD_PHASE_FCNTL] += now - *clock;
+    *clock = now;
+  }
+  FinishProbe(fd, r.st, e, timings, clock);
+  return true;
+}
+
+namespace {
+
+// Re-probes of a torn descriptor in FD_CONSISTENCY_RETRY mode before it is
+// reported as torn.
+constexpr int kMaxConsistencyRetries = 3;
+
+std::atomic<int> g_default_backend{FD_PROBE_SYSCALLS};
+std::atomic<int> g_default_consistency{FD_CONSISTENCY_OFF};
+
+}  // namespace
+
+void SetDefaultProbeBackend(FdProbeBackend backend) {
+  g_default_backend.store(backend == FD_PROBE_DEFAULT ? FD_PROBE_SYSCALLS : backend);
+}
+
+FdProbeBackend DefaultProbeBackend() {
+  return static_cast<FdProbeBackend>(g_default_backend.load());
+}
+
+void SetDefaultConsistencyMode(FdConsistencyMode mode) {
+  g_default_consistency.store(mode == FD_CONSISTENCY_DEFAULT ? FD_CONSISTENCY_OFF : mode);
+}
+
+FdConsistencyMode DefaultConsistencyMode() {
+  return static_cast<FdConsistencyMode>(g_default_consistency.load());
+}
+
+// The probe's first stat is the "before" identity; this stats |fd| again and
+// compares. The extra fstat counts towards the fstat phase.
+static bool SameObjectAfterProbe(int fd, const FdEntry& e, FdPhaseTimings* timings, long long* clock) {
+  struct stat st;
+  bool same = fstat(fd, &st) == 0 && static_cast<unsigned long long>(st.st_dev) == e.dev &&
+              static_cast<unsigned long long>(st.st_ino) == e.inode;
+  long long now = MonotonicNowNs();
+  timings->ns[FD_PHASE_FSTAT] += now - *clock;
+  *clock = now;
+  return same;
+}
+
+// Applies |mode| to a freshly probed |e|. Returns false if the descriptor
+// turned out to be gone and the entry should be dropped.
+static bool CheckConsistency(int fd, FdConsistencyMode mode, FdEntry* e, FdCollectResult* result, long long* clock) {
+  if (mode == FD_CONSISTENCY_OFF) {
+    return true;
+  }
+  for (int attempt = 0;; attempt++) {
+    if (SameObjectAfterProbe(fd, *e, &result->timings, clock)) {
+      return true;
+    }
+    if (mode != FD_CONSISTENCY_RETRY || attempt == kMaxConsistencyRetries) {
+      e->torn = true;
+      result->torn++;
+      return true;
+    }
+    result->retries++;
+    *e = FdEntry();
+    if (!ProbeFd(fd, e, &result->timings, clock)) {
+      return false;
+    }
+  }
+}
+
+FdCollectResult CollectFdList(const FdCollectOptions& options) {
+  std::vector<FdEntry> entries;
+  FdCollectResult result = ForEachFd(options, [&entries](FdEntry& e) {
+    entries.push_back(std::move(e));
+    return true;
+  });
+  result.entries = std::move(entries);
+  return result;
+}
+
+// The budget check made before every probe but the first.
+static bool OutOfBudget(const FdCollectOptions& options, long probes, FdCollectResult* result, int next_fd) {
+  if (probes == 0) {
+    return false;
+  }
+  bool cancelled = options.cancelled != nullptr && options.cancelled->load(std::memory_order_relaxed);
+  bool out_of_probes = options.max_probes >= 0 && probes >= options.max_probes;
+  bool out_of_time = options.has_deadline && std::chrono::steady_clock::now() >= options.deadline;
+  if (cancelled || out_of_probes || out_of_time) {
+    result->truncated = true;
+    result->cancelled = cancelled;
+    result->next_fd = next_fd;
+    return true;
+  }
+  return false;
+}
+
+// Returns the next descriptor number of |dir| at or above |start_fd|, or -1
+// at the end. Time spent here counts as directory scanning.
+static int NextDirFd(DIR* dir, int start_fd, FdPhaseTimings* timings, long long* clock) {
+  for (;;) {
+    struct dirent* ent = readdir(dir);
+    long long now = MonotonicNowNs();
+    timings->ns[FD_PHASE_DIR_SCAN] += now - *clock;
+    *clock = now;
+    if (ent == nullptr) {
+      return -1;
+    }
+    if (ent->d_name[0] == '.') {
+      continue;
+    }
+    int fd = std::atoi(ent->d_name);
+    if (fd >= 0 && fd >= start_fd) {
+      return fd;
+    }
+  }
+}
+
+// The io_uring variant of the probe loop: descriptor numbers are read from
+// |dir| a batch at a time, and each batch's stat and flags come from one
+// FdUringProber round trip, counted as the fstat phase. The budget is still
+// checked before every descriptor, so truncation and |next_fd| behave as in
+// the serial loop. If the ring fails, the rest of the pass uses syscalls.
+static void ForEachFdBatched(DIR* dir, const FdCollectOptions& options, FdConsistencyMode consistency,
+                             FdUringProber* prober, const std::function<bool(FdEntry&)>& visit,
+                             FdCollectResult* result, long long* clock) {
+  FdPhaseTimings& timings = result->timings;
+  const size_t batch_size = prober->batch_size();
+  std::vector<int> fds;
+  std::vector<FdUringResult> probed(batch_size);
+  fds.reserve(batch_size);
+  long probes = 0;
+  bool ring_ok = true;
+  bool done = false;
+  while (!done) {
+    // Never read further ahead than the probe budget allows.
+    size_t want = batch_size;
+    if (options.max_probes >= 0) {
+      long left = std::max(1L, options.max_probes - probes);
+      want = std::min(want, static_cast<size_t>(left));
+    }
+    fds.clear();
+    while (fds.size() < want) {
+      int fd = NextDirFd(dir, options.start_fd, &timings, clock);
+      if (fd < 0) {
+        done = true;
+        break;
+      }
+      if (fd != prober->ring_fd()) {
+        fds.push_back(fd);
+      }
+    }
+    if (fds.empty() || OutOfBudget(options, probes, result, fds[0])) {
+      break;
+    }
+
+    bool batched = ring_ok && prober->Probe(fds.data(), fds.size(), probed.data());
+    ring_ok = batched;
+    long long now = MonotonicNowNs();
+    timings.ns[FD_PHASE_FSTAT] += now - *clock;
+    *clock = now;
+
+    for (size_t i = 0; i < fds.size(); i++) {
+      if (i > 0 && OutOfBudget(options, probes, result, fds[i])) {
+        return;
+      }
+      probes++;
+      FdEntry e;
+      bool ok = batched ? ProbeFdFromUring(fds[i], probed[i], &e, &timings, clock)
+                        : ProbeFd(fds[i], &e, &timings, clock);
+      ok = ok && CheckConsistency(fds[i], consistency, &e, result, clock);
+      if (ok && !visit(e)) {
+        return;
+      }
+      if (ok) {
+        *clock = MonotonicNowNs();
+      }
+    }
+  }
+}
+
+FdCollectResult ForEachFd(const FdCollectOptions& options, const std::function<bool(FdEntry&)>& visit) {
+  FdCollectResult result;
+  FdPhaseTimings& timings = result.timings;
+
+  FdProbeBackend backend = options.backend == FD_PROBE_DEFAULT ? DefaultProbeBackend() : options.backend;
+  FdConsistencyMode consistency =
+      options.consistency == FD_CONSISTENCY_DEFAULT ? DefaultConsistencyMode() : options.consistency;
+  FdUringProber::Lease prober;
+  if (backend == FD_PROBE_IO_URING) {
+    prober = FdUringProber::Acquire();
+  }
+  long long clock = MonotonicNowNs();
+
+  DIR* dir = OpenOwnedDir("/proc/self/fd");
+  if (dir == nullptr) {
+    FdEmergencyDumpNotifyErrno(errno);
+    return result;
+  }
+
+  if (prober != nullptr) {
+    result.used_io_uring = true;
+    ForEachFdBatched(dir, options, consistency, prober.get(), visit, &result, &clock);
+  } else {
+    long probes = 0;
+    for (;;) {
+      // Everything between probes (readdir and the budget checks) counts as
+      // directory scanning.
+      int fd = NextDirFd(dir, options.start_fd, &timings, &clock);
+      if (fd < 0 || OutOfBudget(options, probes, &result, fd)) {
+        break;
+      }
+      probes++;
+
+      FdEntry e;
+      bool probed = ProbeFd(fd, &e, &timings, &clock);
+      probed = probed && CheckConsistency(fd, consistency, &e, &result, &clock);
+      if (probed && !visit(e)) {
+        break;
+      }
+      if (probed) {
+        // Time spent in |visit| belongs to the caller.
+        clock = MonotonicNowNs();
+      }
+    }
+  }
+
+  CloseOwnedDir(dir);
+  timings.ns[FD_PHASE_DIR_SCAN] += MonotonicNowNs() - clock;
+  FdCollectorStats::Instance().RecordPhases(timings);
+  return result;
+}
+
+std::vector<FdEntry> CollectFdList() {
+  return CollectFdList(FdCollectOptions()).entries;
+}
+
+FdTypeCounts CountFdTypes(const std::vector<FdEntry>& list) {
+  FdTypeCounts counts;
+  for (const auto& e : list) {
+    switch (e.fd_type) {
+      case FD_TYPE_VNODE:
+        counts.vnode++;
+        break;
+      case FD_TYPE_SOCKET:
+        counts.socket++;
+        break;
+      case FD_TYPE_PIPE:
+        counts.pipe++;
+        break;
+      default:
+        counts.unknown++;
+        break;
+    }
+    if (e.fd_flags >= 0 && (e.fd_flags & FD_CLOEXEC) == 0) {
+      counts.non_cloexec++;
+    }
+  }
+  return counts;
+}
+
+long CountFds() {
+  int dir_fd = OpenOwnedFd([] { return open("/proc/self/fd", O_RDONLY | O_DIRECTORY | O_CLOEXEC); });
+  if (dir_fd < 0) {
+    int err = errno;
+    FdEmergencyDumpNotifyErrno(err);
+    return -err;
+  }
+
+  // getdents64 records: u64 ino, s64 off, u16 reclen, u8 type, name.
+  alignas(8) char buf[8192];
+  long count = 0;
+  for (;;) {
+    long n = syscall(SYS_getdents64, dir_fd, buf, sizeof(buf));
+    if (n <= 0) break;
+    for (long off = 0; off < n;) {
+      unsigned short reclen;
+      std::memcpy(&reclen, buf + off + 16, sizeof(reclen));
+      if (buf[off + 19] != '.') {
+        count++;
+      }
+      off += reclen;
+    }
+  }
+
+  CloseOwnedFd(dir_fd);
+  return count - 1;
+}
+
+namespace {
+
+// Renders the fields of fd_entry_schema.h as one line of space-separated
+// key=value pairs. Fields whose rendered value is empty are left out.
+class FdTextEncoder {
+ public:
+  explicit FdTextEncoder(std::string* out) : out_(out), line_start_(out->size()) {}
+
+  void Int(const FdField& f, long long value, bool, bool in_text) {
+    if (!in_text || f.text_key == nullptr) return;
+    size_t mark = Key(f);
+    switch (f.format) {
+      case FD_FORMAT_OCTAL: {
+        char oct[24];
+        std::snprintf(oct, sizeof(oct), "%llo", static_cast<unsigned long long>(value));
+        out_->append(oct);
+        break;
+      }
+      case FD_FORMAT_OPEN_FLAGS:
+        AppendOpenFlags(out_, static_cast<int>(value));
+        break;
+      case FD_FORMAT_FD_FLAGS:
+        if ((value & FD_CLOEXEC) != 0) out_->append("CLOEXEC");
+        break;
+      default:
+        out_->append(std::to_string(value));
+    }
+    End(mark);
+  }
+
+  void Bool(const FdField& f, bool value, bool, bool in_text) {
+    if (!in_text || f.text_key == nullptr) return;
+    size_t mark = Key(f);
+    out_->push_back(value ? '1' : '0');
+    End(mark);
+  }
+
+  void String(const FdField& f, const std::string& value, bool, bool in_text) {
+    if (!in_text || f.text_key == nullptr) return;
+    size_t mark = Key(f);
+    out_->append(value);
+    End(mark);
+  }
+
+  void Named(const FdField& f, long long value, const std::string& name, bool, bool in_text) {
+    if (!in_text || f.text_key == nullptr) return;
+    size_t mark = Key(f);
+    out_->append(name);
+    if (f.format == FD_FORMAT_NAME_AND_VALUE) {
+      out_->push_back('(');
+      out_->append(std::to_string(value));
+      out_->push_back(')');
+    }
+    End(mark);
+  }
+
+ private:
+  // Appends " key=" and returns where it starts, for End() to undo.
+  size_t Key(const FdField& f) {
+    size_t mark = out_->size();
+    if (mark > line_start_) out_->push_back(' ');
+    out_->append(f.text_key);
+    out_->push_back('=');
+    value_start_ = out_->size();
+    return mark;
+  }
+
+  void End(size_t mark) {
+    if (out_->size() == value_start_) out_->resize(mark);
+  }
+
+  std::string* out_;
+  size_t line_start_;
+  size_t value_start_ = 0;
+};
+
+}  // namespace
+
+std::string BuildFdReport(const std::vector<FdEntry>& list, int truncated_at_fd, FdPhaseTimings* timings) {
+  long long format_start = MonotonicNowNs();
+  std::string out;
+  out.reserve(128 + list.size() * 96);
+
+  out.append("timestamp_utc: ").append(Iso8601Now()).append("\n");
+  out.append("pid: ").append(std::to_string(getpid())).append("\n");
+  struct rlimit lim;
+  if (getrlimit(RLIMIT_NOFILE, &lim) == 0) {
+    out.append("rlimit_nofile_cur: ").append(std::to_string(static_cast<unsigned long long>(lim.rlim_cur))).append("\n");
+    out.append("rlimit_nofile_max: ").append(std::to_string(static_cast<unsigned long long>(lim.rlim_max))).append("\n");
+  } else {
+    out.append("getrlimit(RLIMIT_NOFILE) failed errno=").append(std::to_string(errno)).append("\n");
+  }
+
+  out.append("fd_count: ").append(std::to_string(list.size())).append("\n");
+  if (truncated_at_fd >= 0) {
+    out.append("truncated_at_fd: ").append(std::to_string(truncated_at_fd));
+    out.append(" (partial; resume with startFd=").append(std::to_string(truncated_at_fd)).append(")\n");
+  }
+  out.append("\nfd_type_counts:\n");
+  std::map<std::string, int> type_counts;
+  for (const auto& e : list) {
+    type_counts[e.fd_type_name] += 1;
+  }
+  for (const auto& kv : type_counts) {
+    out.append("  ").append(kv.first).append(": ").append(std::to_string(kv.second)).append("\n");
+  }
+
+  out.append("\nfd_details:\n");
+  for (const auto& e : list) {
+    FdTextEncoder encoder(&out);
+    VisitFdEntry(e, &encoder);
+    out.push_back('\n');
+  }
+
+  long long format_ns = MonotonicNowNs() - format_start;
+  FdCollectorStats::Instance().RecordPhase(FD_PHASE_FORMAT, format_ns);
+  if (timings != nullptr) {
+    timings->ns[FD_PHASE_FORMAT] += format_ns;
+    out.append("\nphase_timings_us:\n");
+    for (int phase = 0; phase < FD_PHASE_COUNT; phase++) {
+      if (timings->ns[phase] > 0) {
+        out.append("  ").append(FdPhaseName(phase)).append(": ").append(std::to_string(timings->ns[phase] / 1000)).append("\n");
+      }
+    }
+  }
+
+  return out;
+}
+
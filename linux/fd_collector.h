@@ -0,0 +1,176 @@
+#ifndef FLUTTER_FD_UTILS_FD_COLLECTOR_H_
+#define FLUTTER_FD_UTILS_FD_COLLECTOR_H_
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "fd_collector_stats.h"
+
+// Collection and text formatting of the current process file descriptors.
+// Nothing in here depends on the Flutter embedder, so it can be shared by the
+// method channel handlers and the native-only entry points.
+
+#define FD_TYPE_UNKNOWN 0
+#define FD_TYPE_VNODE 1
+#define FD_TYPE_SOCKET 2
+#define FD_TYPE_PIPE 6
+
+struct SocketDetails {
+  bool present = false;
+  bool has_so_type = false;
+  int so_type = 0;
+  bool has_so_proto = false;
+  int so_proto = 0;
+  bool has_family = false;
+  int family = 0;
+  std::string local;
+  std::string peer;
+  bool has_tcp_state = false;
+  int tcp_state = 0;
+  std::string tcp_state_name;
+};
+
+struct VnodeDetails {
+  bool present = false;
+  int mode = 0;
+  long long size = 0;
+  long long nlink = 0;
+  // Space allocated on disk (st_blocks * 512).
+  long long disk_bytes = 0;
+  // The last link is gone but the descriptor keeps the inode alive.
+  bool deleted = false;
+  // Filled in by JoinFileUsage() when /proc/self/maps has been read.
+  bool mapped = false;
+  long long mapped_bytes = 0;
+};
+
+struct FdEntry {
+  int fd = -1;
+  int fd_type = FD_TYPE_UNKNOWN;
+  std::string fd_type_name;
+  int open_flags = -1;
+  int fd_flags = -1;
+  std::string path;
+  // st_dev / st_ino of the open object, for joins and reuse detection.
+  unsigned long long dev = 0;
+  unsigned long long inode = 0;
+  // The descriptor was closed or referred to a different object by the end of
+  // the probe, so the fields may mix two objects. Only set in consistency
+  // mode.
+  bool torn = false;
+  SocketDetails socket;
+  VnodeDetails vnode;
+};
+const char* FdTypeName(int type);
+
+// Renders F_GETFL / F_GETFD values the way the text report prints them.
+std::string OpenFlagsString(int open_flags);
+std::string FdFlagsString(int fd_flags);
+
+// How a collection pass gets each descriptor's stat and flags.
+enum FdProbeBackend {
+  // Whatever SetDefaultProbeBackend() selected; syscalls unless changed.
+  FD_PROBE_DEFAULT,
+  // fstat() and fcntl() per descriptor.
+  FD_PROBE_SYSCALLS,
+  // Batched statx and fdinfo reads through io_uring (fd_uring_probe.h).
+  // Falls back to syscalls when io_uring is unavailable.
+  FD_PROBE_IO_URING,
+};
+
+// Sets the backend used by passes whose options leave it at
+// FD_PROBE_DEFAULT, including the snapshot cache and the monitor.
+void SetDefaultProbeBackend(FdProbeBackend backend);
+FdProbeBackend DefaultProbeBackend();
+
+// Whether a collection pass checks that a descriptor still refers to the same
+// object (dev, inode) after it has been probed. Without the check, a
+// descriptor closed and reused by another thread mid-probe silently yields an
+// entry that mixes attributes of both objects.
+enum FdConsistencyMode {
+  // Whatever SetDefaultConsistencyMode() selected; off unless changed.
+  FD_CONSISTENCY_DEFAULT,
+  FD_CONSISTENCY_OFF,
+  // Re-stat after probing and flag mismatches as FdEntry::torn.
+  FD_CONSISTENCY_MARK,
+  // Like MARK, but probe a torn descriptor again (a few times) first; one
+  // closed for good is dropped.
+  FD_CONSISTENCY_RETRY,
+};
+
+void SetDefaultConsistencyMode(FdConsistencyMode mode);
+FdConsistencyMode DefaultConsistencyMode();
+
+// Limits for a single collection pass. The default options collect
+// everything.
+struct FdCollectOptions {
+  // Descriptors below this are skipped; pass FdCollectResult::next_fd to
+  // continue a truncated pass.
+  int start_fd = 0;
+  bool has_deadline = false;
+  std::chrono::steady_clock::time_point deadline;
+  // Maximum number of descriptors to probe, or -1 for no limit.
+  long max_probes = -1;
+  // Polled between descriptors; setting it stops the pass.
+  const std::atomic<bool>* cancelled = nullptr;
+  FdProbeBackend backend = FD_PROBE_DEFAULT;
+  FdConsistencyMode consistency = FD_CONSISTENCY_DEFAULT;
+};
+
+struct FdCollectResult {
+  std::vector<FdEntry> entries;
+  // True if the pass stopped before the end of the fd table.
+  bool truncated = false;
+  bool cancelled = false;
+  // First descriptor not probed when truncated, otherwise -1.
+  int next_fd = -1;
+  // Time spent in each collection phase of this pass.
+  FdPhaseTimings timings;
+  // Whether the pass actually ran on io_uring.
+  bool used_io_uring = false;
+  // Consistency mode only: entries still marked torn, and re-probes made.
+  long torn = 0;
+  long retries = 0;
+};
+
+// Probes descriptors in ascending order until the table ends or |options|
+// says to stop. At least one descriptor is probed per call so continuations
+// always make progress. The phase timings of every pass are also recorded in
+// FdCollectorStats.
+FdCollectResult CollectFdList(const FdCollectOptions& options);
+
+std::vector<FdEntry> CollectFdList();
+
+// Same pass as CollectFdList(options), but hands each entry to |visit| instead
+// of accumulating them, so memory does not grow with the fd table. |visit| may
+// move from the entry. Returning false from it stops the pass; the result's
+// entries are left empty.
+FdCollectResult ForEachFd(const FdCollectOptions& options, const std::function<bool(FdEntry&)>& visit);
+
+struct FdTypeCounts {
+  long long vnode = 0;
+  long long socket = 0;
+  long long pipe = 0;
+  long long unknown = 0;
+  // Descriptors without FD_CLOEXEC, i.e. inherited across exec().
+  long long non_cloexec = 0;
+};
+
+FdTypeCounts CountFdTypes(const std::vector<FdEntry>& list);
+
+// Counts the entries of /proc/self/fd without allocating; the descriptor used
+// for the scan is not counted. Returns -errno on failure.
+long CountFds();
+
+// Current UTC time as used in report headers, e.g. 2024-01-02T03:04:05.678Z.
+std::string Iso8601Now();
+
+// |truncated_at_fd| >= 0 marks a partial report and names the resume cursor.
+// When |timings| is given, the formatting time is added to it and the report
+// ends with a phase_timings_us section.
+std::string BuildFdReport(const std::vector<FdEntry>& list, int truncated_at_fd = -1, FdPhaseTimings* timings = nullptr);
+
+#endif  // FLUTTER_FD_UTILS_FD_COLLECTOR_H_
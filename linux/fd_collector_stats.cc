@@ -0,0 +1,189 @@
+#include "fd_collector_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+
+const char* FdPhaseName(int phase) {
+  switch (phase) {
+    case FD_PHASE_DIR_SCAN:
+      return "dir_scan";
+    case FD_PHASE_FSTAT:
+      return "fstat";
+    case FD_PHASE_FCNTL:
+      return "fcntl";
+    case FD_PHASE_READLINK:
+      return "readlink";
+    case FD_PHASE_SOCKET_PROBE:
+      return "socket_probe";
+    case FD_PHASE_ENCODE:
+      return "encode";
+    case FD_PHASE_FORMAT:
+      return "format";
+    default:
+      return "unknown";
+  }
+}
+
+long long MonotonicNowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<long long>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+void FdPhaseTimings::Add(const FdPhaseTimings& other) {
+  for (int i = 0; i < FD_PHASE_COUNT; i++) {
+    ns[i] += other.ns[i];
+  }
+}
+
+LatencyHistogram::LatencyHistogram() : counts_(kBucketCount, 0), count_(0), min_(0), max_(0), sum_(0) {}
+
+// Values below 32 get a bucket each. Above that, a value whose highest set bit
+// is b lands in one of 16 equal sub-buckets of [2^b, 2^(b+1)).
+int LatencyHistogram::BucketIndex(long long ns) {
+  if (ns < 32) {
+    return ns < 0 ? 0 : static_cast<int>(ns);
+  }
+  int msb = 63 - __builtin_clzll(static_cast<unsigned long long>(ns));
+  int shift = msb - kSubBucketBits;
+  if (shift > kMaxShift) {
+    return kBucketCount - 1;
+  }
+  int sub = static_cast<int>(ns >> shift) - 16;
+  return 32 + (shift - 1) * 16 + sub;
+}
+
+long long LatencyHistogram::BucketUpperBound(int index) {
+  if (index < 32) {
+    return index;
+  }
+  int shift = (index - 32) / 16 + 1;
+  long long sub = (index - 32) % 16 + 16;
+  return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(long long ns) {
+  if (ns < 0) ns = 0;
+  counts_[BucketIndex(ns)]++;
+  if (count_ == 0 || ns < min_) min_ = ns;
+  if (ns > max_) max_ = ns;
+  count_++;
+  sum_ += ns;
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+  if (other.count_ == 0) {
+    return;
+  }
+  for (int i = 0; i < kBucketCount; i++) {
+    counts_[i] += other.counts_[i];
+  }
+  if (count_ == 0 || other.min_ < min_) min_ = other.min_;
+  max_ = std::max(max_, other.max_);
+  count_ += other.count_;
+  sum_ += other.sum_;
+}
+
+void LatencyHistogram::Clear() {
+  std::fill(counts_.begin(), counts_.end(), 0);
+  count_ = 0;
+  min_ = 0;
+  max_ = 0;
+  sum_ = 0;
+}
+
+long long LatencyHistogram::ValueAtPercentile(double percentile) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  long long rank = static_cast<long long>(std::ceil(percentile / 100.0 * static_cast<double>(count_)));
+  rank = std::max(1LL, std::min(rank, count_));
+  long long seen = 0;
+  for (int i = 0; i < kBucketCount; i++) {
+    seen += counts_[i];
+    if (seen >= rank) {
+      return std::min(std::max(BucketUpperBound(i), min_), max_);
+    }
+  }
+  return max_;
+}
+
+std::vector<std::pair<long long, long long>> LatencyHistogram::Buckets() const {
+  std::vector<std::pair<long long, long long>> buckets;
+  for (int i = 0; i < kBucketCount; i++) {
+    if (counts_[i] != 0) {
+      buckets.emplace_back(BucketUpperBound(i), counts_[i]);
+    }
+  }
+  return buckets;
+}
+
+FdCollectorStats& FdCollectorStats::Instance() {
+  static FdCollectorStats* instance = new FdCollectorStats();
+  return *instance;
+}
+
+FdCollectorStats::Slot& FdCollectorStats::CurrentSlot() {
+  long long epoch = MonotonicNowNs() / 1000000 / kSlotMs;
+  Slot& slot = slots_[epoch % kSlots];
+  if (slot.epoch != epoch) {
+    for (auto& h : slot.phases) {
+      h.Clear();
+    }
+    slot.methods.clear();
+    slot.epoch = epoch;
+  }
+  return slot;
+}
+
+void FdCollectorStats::RecordPhases(const FdPhaseTimings& timings) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Slot& slot = CurrentSlot();
+  for (int i = 0; i < FD_PHASE_COUNT; i++) {
+    if (timings.ns[i] > 0) {
+      slot.phases[i].Record(timings.ns[i]);
+    }
+  }
+}
+
+void FdCollectorStats::RecordPhase(FdPhase phase, long long ns) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  CurrentSlot().phases[phase].Record(ns);
+}
+
+void FdCollectorStats::RecordMethod(const std::string& method, long long ns) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  CurrentSlot().methods[method].Record(ns);
+}
+
+FdCollectorStats::Window FdCollectorStats::Read() {
+  Window window;
+  window.window_ms = kSlots * kSlotMs;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  long long epoch = MonotonicNowNs() / 1000000 / kSlotMs;
+  for (const Slot& slot : slots_) {
+    if (slot.epoch < 0 || epoch - slot.epoch >= kSlots) {
+      continue;
+    }
+    for (int i = 0; i < FD_PHASE_COUNT; i++) {
+      window.phases[i].Merge(slot.phases[i]);
+    }
+    for (const auto& kv : slot.methods) {
+      window.methods[kv.first].Merge(kv.second);
+    }
+  }
+  return window;
+}
+
+void FdCollectorStats::Reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (Slot& slot : slots_) {
+    for (auto& h : slot.phases) {
+      h.Clear();
+    }
+    slot.methods.clear();
+    slot.epoch = -1;
+  }
+}
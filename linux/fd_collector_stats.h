@@ -0,0 +1,123 @@
+#ifndef FLUTTER_FD_UTILS_FD_COLLECTOR_STATS_H_
+#define FLUTTER_FD_UTILS_FD_COLLECTOR_STATS_H_
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Timing of collection phases and method calls.
+//
+// Phases are timed with one CLOCK_MONOTONIC read per phase boundary (the end
+// of one phase is the start of the next), so instrumentation costs a few vDSO
+// calls per descriptor. Each collection or response records one sample per
+// phase into process-wide rolling histograms.
+
+enum FdPhase {
+  // opendir/readdir/closedir of /proc/self/fd.
+  FD_PHASE_DIR_SCAN = 0,
+  FD_PHASE_FSTAT,
+  // F_GETFL / F_GETFD.
+  FD_PHASE_FCNTL,
+  FD_PHASE_READLINK,
+  // getsockopt / getsockname / getpeername on sockets.
+  FD_PHASE_SOCKET_PROBE,
+  // FlValue encoding of entries.
+  FD_PHASE_ENCODE,
+  // Text report or NDJSON rendering.
+  FD_PHASE_FORMAT,
+  FD_PHASE_COUNT,
+};
+
+// snake_case name used in reports and method channel maps.
+const char* FdPhaseName(int phase);
+
+long long MonotonicNowNs();
+
+struct FdPhaseTimings {
+  long long ns[FD_PHASE_COUNT] = {};
+
+  void Add(const FdPhaseTimings& other);
+};
+
+// Log-linear (HDR-style) histogram of nanosecond latencies. Values are kept
+// in 16 sub-buckets per power of two, so every reported value is within
+// about 6% of a recorded one. Values of 2^45 ns (~9.8 hours) and above are
+// clamped.
+class LatencyHistogram {
+ public:
+  LatencyHistogram();
+
+  void Record(long long ns);
+  void Merge(const LatencyHistogram& other);
+  void Clear();
+
+  long long count() const { return count_; }
+  long long min() const { return count_ > 0 ? min_ : 0; }
+  long long max() const { return max_; }
+  long long sum() const { return sum_; }
+
+  // Upper bound of the bucket holding the |percentile|th value (0-100).
+  long long ValueAtPercentile(double percentile) const;
+
+  // Non-empty buckets as (inclusive upper bound in ns, count).
+  std::vector<std::pair<long long, long long>> Buckets() const;
+
+ private:
+  static constexpr int kSubBucketBits = 4;
+  static constexpr int kMaxShift = 40;
+  static constexpr int kBucketCount = 32 + kMaxShift * 16;
+
+  static int BucketIndex(long long ns);
+  static long long BucketUpperBound(int index);
+
+  std::vector<uint32_t> counts_;
+  long long count_;
+  long long min_;
+  long long max_;
+  long long sum_;
+};
+
+// Process-wide rolling latency histograms per phase and per method. Samples
+// older than the window (kSlots * kSlotMs) age out a slot at a time.
+class FdCollectorStats {
+ public:
+  static constexpr int kSlots = 4;
+  static constexpr long long kSlotMs = 15000;
+
+  struct Window {
+    long long window_ms = 0;
+    LatencyHistogram phases[FD_PHASE_COUNT];
+    std::map<std::string, LatencyHistogram> methods;
+  };
+
+  static FdCollectorStats& Instance();
+
+  // Records every phase with a non-zero time.
+  void RecordPhases(const FdPhaseTimings& timings);
+  void RecordPhase(FdPhase phase, long long ns);
+  void RecordMethod(const std::string& method, long long ns);
+
+  // Merges the slots still inside the window.
+  Window Read();
+  void Reset();
+
+ private:
+  struct Slot {
+    long long epoch = -1;
+    LatencyHistogram phases[FD_PHASE_COUNT];
+    std::map<std::string, LatencyHistogram> methods;
+  };
+
+  FdCollectorStats() = default;
+
+  // Requires mutex_. Returns the slot for now, clearing it if it is stale.
+  Slot& CurrentSlot();
+
+  std::mutex mutex_;
+  Slot slots_[kSlots];
+};
+
+#endif  // FLUTTER_FD_UTILS_FD_COLLECTOR_STATS_H_
@@ -0,0 +1,363 @@
+#include "fd_emergency_dump.h"
+
+#include "fd_table_ops.h"
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t kOutBufferSize = 64 * 1024;
+constexpr size_t kDentsBufferSize = 16 * 1024;
+constexpr size_t kLinkBufferSize = 512;
+
+const int kFatalSignals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+
+// Layout of the records returned by getdents64(2); glibc does not export it.
+struct LinuxDirent64 {
+  uint64_t d_ino;
+  int64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[];
+};
+
+// All state is static so nothing is allocated once the dumper is installed.
+std::atomic<bool> g_installed{false};
+std::atomic_flag g_dumping = ATOMIC_FLAG_INIT;
+std::atomic<bool> g_emfile_seen{false};
+// A returning handler re-runs a faulting instruction; dump only on the first
+// pass.
+std::atomic<bool> g_fatal_dumped{false};
+bool g_dump_on_emfile = false;
+int g_out_fd = -1;
+int g_dir_fd = -1;
+int g_trigger_signal = 0;
+
+char g_out[kOutBufferSize];
+size_t g_out_len = 0;
+long g_written = 0;
+alignas(8) char g_dents[kDentsBufferSize];
+char g_link[kLinkBufferSize];
+
+struct SavedAction {
+  bool saved = false;
+  struct sigaction action;
+};
+SavedAction g_prev_actions[NSIG];
+
+void WriteAll(const char* data, size_t len) {
+  while (len > 0) {
+    ssize_t n = write(g_out_fd, data, len);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return;
+    }
+    data += n;
+    len -= static_cast<size_t>(n);
+    g_written += n;
+  }
+}
+
+void Flush() {
+  WriteAll(g_out, g_out_len);
+  g_out_len = 0;
+}
+
+void Append(const char* s, size_t len) {
+  if (g_out_len + len > kOutBufferSize) {
+    Flush();
+  }
+  if (len > kOutBufferSize) {
+    WriteAll(s, len);
+    return;
+  }
+  memcpy(g_out + g_out_len, s, len);
+  g_out_len += len;
+}
+
+void AppendStr(const char* s) {
+  Append(s, strlen(s));
+}
+
+void AppendUnsigned(unsigned long long v, unsigned base) {
+  char tmp[24];
+  size_t i = sizeof(tmp);
+  do {
+    unsigned digit = static_cast<unsigned>(v % base);
+    tmp[--i] = static_cast<char>(digit < 10 ? '0' + digit : 'a' + digit - 10);
+    v /= base;
+  } while (v != 0);
+  Append(tmp + i, sizeof(tmp) - i);
+}
+
+void AppendSigned(long long v) {
+  if (v < 0) {
+    Append("-", 1);
+    AppendUnsigned(0ULL - static_cast<unsigned long long>(v), 10);
+    return;
+  }
+  AppendUnsigned(static_cast<unsigned long long>(v), 10);
+}
+
+// Parses a decimal descriptor name from /proc/self/fd; -1 for "." and "..".
+int ParseFd(const char* name) {
+  if (*name < '0' || *name > '9') return -1;
+  int v = 0;
+  for (; *name >= '0' && *name <= '9'; name++) {
+    v = v * 10 + (*name - '0');
+  }
+  return v;
+}
+
+const char* SignalName(int sig) {
+  switch (sig) {
+    case SIGSEGV:
+      return "SIGSEGV";
+    case SIGBUS:
+      return "SIGBUS";
+    case SIGFPE:
+      return "SIGFPE";
+    case SIGILL:
+      return "SIGILL";
+    case SIGABRT:
+      return "SIGABRT";
+    default:
+      return "signal";
+  }
+}
+
+long DumpLocked(const char* reason) {
+  g_out_len = 0;
+  g_written = 0;
+
+  struct timespec mono;
+  clock_gettime(CLOCK_MONOTONIC, &mono);
+  struct timespec wall;
+  clock_gettime(CLOCK_REALTIME, &wall);
+
+  AppendStr("=== flutter_fd_utils emergency fd dump ===\n");
+  AppendStr("pid: ");
+  AppendSigned(getpid());
+  AppendStr("\nreason: ");
+  AppendStr(reason != nullptr ? reason : "manual");
+  AppendStr("\nunix_time: ");
+  AppendSigned(wall.tv_sec);
+  AppendStr("\nmonotonic_ms: ");
+  AppendSigned(static_cast<long long>(mono.tv_sec) * 1000 + mono.tv_nsec / 1000000);
+  struct rlimit lim;
+  if (getrlimit(RLIMIT_NOFILE, &lim) == 0) {
+    AppendStr("\nrlimit_nofile_cur: ");
+    AppendUnsigned(lim.rlim_cur, 10);
+    AppendStr("\nrlimit_nofile_max: ");
+    AppendUnsigned(lim.rlim_max, 10);
+  }
+  AppendStr("\n");
+
+  long count = 0;
+  if (lseek(g_dir_fd, 0, SEEK_SET) == 0) {
+    for (;;) {
+      long n = syscall(SYS_getdents64, g_dir_fd, g_dents, sizeof(g_dents));
+      if (n <= 0) break;
+      for (long off = 0; off < n;) {
+        const LinuxDirent64* d = reinterpret_cast<const LinuxDirent64*>(g_dents + off);
+        off += d->d_reclen;
+        int fd = ParseFd(d->d_name);
+        if (fd < 0 || fd == g_dir_fd || fd == g_out_fd) continue;
+
+        count++;
+        AppendStr("fd=");
+        AppendSigned(fd);
+        AppendStr(" fl=0x");
+        AppendUnsigned(static_cast<unsigned>(fcntl(fd, F_GETFL)), 16);
+        AppendStr(" fdfl=");
+        AppendSigned(fcntl(fd, F_GETFD));
+        ssize_t len = readlinkat(g_dir_fd, d->d_name, g_link, sizeof(g_link));
+        if (len > 0) {
+          AppendStr(" -> ");
+          Append(g_link, static_cast<size_t>(len));
+        }
+        AppendStr("\n");
+      }
+    }
+  }
+
+  AppendStr("fd_count: ");
+  AppendSigned(count);
+  AppendStr("\n=== end ===\n");
+  Flush();
+  return g_written;
+}
+
+void TriggerSignalHandler(int /*sig*/) {
+  int saved_errno = errno;
+  FdEmergencyDumpWrite("signal");
+  errno = saved_errno;
+}
+
+// Signals raised by the faulting instruction itself; returning from the
+// handler would only execute it again.
+bool IsSynchronousFault(int sig) {
+  return sig == SIGSEGV || sig == SIGBUS || sig == SIGILL || sig == SIGFPE;
+}
+
+void FatalSignalHandler(int sig, siginfo_t* info, void* ucontext) {
+  int saved_errno = errno;
+  if (!g_fatal_dumped.exchange(true)) {
+    char reason[32] = "fatal:";
+    strncat(reason, SignalName(sig), sizeof(reason) - strlen(reason) - 1);
+    FdEmergencyDumpWrite(reason);
+  }
+  errno = saved_errno;
+
+  // Chain to whatever was installed before us. If that returns, or ignored the
+  // signal, a synchronous fault is re-raised with the default disposition so
+  // the process dies instead of faulting in a loop.
+  const struct sigaction& prev = g_prev_actions[sig].action;
+  bool fault = IsSynchronousFault(sig);
+  if ((prev.sa_flags & SA_SIGINFO) != 0 && prev.sa_sigaction != nullptr) {
+    prev.sa_sigaction(sig, info, ucontext);
+    if (!fault) return;
+  } else if (prev.sa_handler == SIG_IGN) {
+    if (!fault) return;
+  } else if (prev.sa_handler != SIG_DFL && prev.sa_handler != nullptr) {
+    prev.sa_handler(sig);
+    if (!fault) return;
+  }
+  struct sigaction dfl;
+  memset(&dfl, 0, sizeof(dfl));
+  sigemptyset(&dfl.sa_mask);
+  dfl.sa_handler = SIG_DFL;
+  sigaction(sig, &dfl, nullptr);
+  raise(sig);
+}
+
+bool InstallHandler(int sig, void (*handler)(int), void (*action)(int, siginfo_t*, void*)) {
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sigemptyset(&sa.sa_mask);
+  sa.sa_flags = SA_RESTART | SA_ONSTACK;
+  if (action != nullptr) {
+    sa.sa_flags |= SA_SIGINFO;
+    sa.sa_sigaction = action;
+  } else {
+    sa.sa_handler = handler;
+  }
+  if (sigaction(sig, &sa, &g_prev_actions[sig].action) != 0) {
+    return false;
+  }
+  g_prev_actions[sig].saved = true;
+  return true;
+}
+
+void RestoreHandlers() {
+  for (int sig = 1; sig < NSIG; sig++) {
+    if (g_prev_actions[sig].saved) {
+      sigaction(sig, &g_prev_actions[sig].action, nullptr);
+      g_prev_actions[sig].saved = false;
+    }
+  }
+}
+
+}  // namespace
+
+bool FdEmergencyDumpInstall(const FdEmergencyDumpConfig& config, int* out_errno) {
+  FdEmergencyDumpUninstall();
+
+  int out_fd = OpenOwnedFd([&config] { return open(config.path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644); });
+  if (out_fd < 0) {
+    if (out_errno != nullptr) *out_errno = errno;
+    return false;
+  }
+  int dir_fd = OpenOwnedFd([] { return open("/proc/self/fd", O_RDONLY | O_DIRECTORY | O_CLOEXEC); });
+  if (dir_fd < 0) {
+    if (out_errno != nullptr) *out_errno = errno;
+    CloseOwnedFd(out_fd);
+    return false;
+  }
+
+  // Touch the buffers now so a dump never has to fault in fresh pages.
+  memset(g_out, 0, sizeof(g_out));
+  memset(g_dents, 0, sizeof(g_dents));
+  memset(g_link, 0, sizeof(g_link));
+
+  g_out_fd = out_fd;
+  g_dir_fd = dir_fd;
+  g_dump_on_emfile = config.dump_on_emfile;
+  g_emfile_seen.store(false);
+  g_fatal_dumped.store(false);
+  g_installed.store(true);
+
+  if (config.trigger_signal > 0 && config.trigger_signal < NSIG) {
+    if (InstallHandler(config.trigger_signal, TriggerSignalHandler, nullptr)) {
+      g_trigger_signal = config.trigger_signal;
+    }
+  }
+  if (config.dump_on_fatal_signal) {
+    for (int sig : kFatalSignals) {
+      if (sig != g_trigger_signal) {
+        InstallHandler(sig, nullptr, FatalSignalHandler);
+      }
+    }
+  }
+  return true;
+}
+
+void FdEmergencyDumpUninstall() {
+  RestoreHandlers();
+  g_trigger_signal = 0;
+  if (!g_installed.exchange(false)) {
+    return;
+  }
+
+  // Wait for a dump running on another thread before closing its descriptors.
+  while (g_dumping.test_and_set(std::memory_order_acquire)) {
+    sched_yield();
+  }
+  CloseOwnedFd(g_out_fd);
+  CloseOwnedFd(g_dir_fd);
+  g_out_fd = -1;
+  g_dir_fd = -1;
+  g_dumping.clear(std::memory_order_release);
+}
+
+bool FdEmergencyDumpIsInstalled() {
+  return g_installed.load();
+}
+
+long FdEmergencyDumpWrite(const char* reason) {
+  if (!g_installed.load()) {
+    return -1;
+  }
+  if (g_dumping.test_and_set(std::memory_order_acquire)) {
+    return -1;
+  }
+  long written = -1;
+  if (g_installed.load()) {
+    written = DumpLocked(reason);
+  }
+  g_dumping.clear(std::memory_order_release);
+  return written;
+}
+
+void FdEmergencyDumpNotifyErrno(int err) {
+  if (err != EMFILE && err != ENFILE) {
+    return;
+  }
+  if (!g_installed.load() || !g_dump_on_emfile) {
+    return;
+  }
+  if (g_emfile_seen.exchange(true)) {
+    return;
+  }
+  FdEmergencyDumpWrite(err == EMFILE ? "emfile" : "enfile");
+}
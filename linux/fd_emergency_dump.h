@@ -0,0 +1,46 @@
+#ifndef FLUTTER_FD_UTILS_FD_EMERGENCY_DUMP_H_
+#define FLUTTER_FD_UTILS_FD_EMERGENCY_DUMP_H_
+
+#include <string>
+
+// Emergency file descriptor dumper.
+//
+// Everything a dump needs (the output descriptor, a descriptor for
+// /proc/self/fd and the formatting buffers) is acquired by
+// FdEmergencyDumpInstall(), so a dump can still be written once the process
+// has hit RLIMIT_NOFILE or from inside a signal handler. The dump path only
+// uses raw syscalls (getdents64, readlinkat, fcntl, write).
+
+struct FdEmergencyDumpConfig {
+  // File the dump is appended to. Opened once, at install time.
+  std::string path;
+  // Signal that writes a dump when delivered (e.g. SIGUSR2), or 0 for none.
+  int trigger_signal = 0;
+  // Write a dump before chaining to the previous SIGSEGV/SIGBUS/SIGFPE/
+  // SIGILL/SIGABRT disposition.
+  bool dump_on_fatal_signal = true;
+  // Write a dump the first time FdEmergencyDumpNotifyErrno() sees
+  // EMFILE/ENFILE.
+  bool dump_on_emfile = true;
+};
+
+// Installs the dumper, replacing any previous installation. Returns false and
+// sets |out_errno| if the output file or /proc/self/fd cannot be opened.
+bool FdEmergencyDumpInstall(const FdEmergencyDumpConfig& config, int* out_errno);
+
+// Restores the previous signal dispositions and releases the preallocated
+// descriptors.
+void FdEmergencyDumpUninstall();
+
+bool FdEmergencyDumpIsInstalled();
+
+// Writes one snapshot to the preallocated output descriptor.
+// Async-signal-safe. Returns the number of bytes written, or -1 if the dumper
+// is not installed or a dump is already in progress.
+long FdEmergencyDumpWrite(const char* reason);
+
+// Reports the errno of a failed descriptor-allocating call. The first
+// EMFILE/ENFILE observed after install triggers a dump. Async-signal-safe.
+void FdEmergencyDumpNotifyErrno(int err);
+
+#endif  // FLUTTER_FD_UTILS_FD_EMERGENCY_DUMP_H_
@@ -0,0 +1,112 @@
+#ifndef FLUTTER_FD_UTILS_FD_ENTRY_SCHEMA_H_
+#define FLUTTER_FD_UTILS_FD_ENTRY_SCHEMA_H_
+
+#include <string>
+
+#include "fd_collector.h"
+
+// The fields of an FdEntry as the text report and the structured list show
+// them. Each field is declared once below, and VisitFdEntry() hands every
+// field of an entry to an encoder exactly once, in report order. Encoders
+// (the report's text encoder in fd_collector.cc, the FlValue encoder in the
+// plugin) only decide how a value is rendered, never which fields exist.
+
+// Nested object a field belongs to in the list; the text report is flat.
+enum FdFieldGroup {
+  FD_GROUP_ENTRY,
+  FD_GROUP_SOCKET,
+  FD_GROUP_VNODE,
+};
+
+// How the text report renders a value.
+enum FdFieldFormat {
+  FD_FORMAT_DECIMAL,
+  FD_FORMAT_OCTAL,
+  FD_FORMAT_OPEN_FLAGS,
+  FD_FORMAT_FD_FLAGS,
+  // Named values print only the name, or "name(value)".
+  FD_FORMAT_NAME,
+  FD_FORMAT_NAME_AND_VALUE,
+};
+
+// The list encodes an empty string or a negative number as null instead of
+// the value.
+#define FD_FIELD_NULLABLE 0x1
+
+struct FdField {
+  // Key in the text report, or nullptr if the report leaves it out.
+  const char* text_key;
+  // Key in the list, or nullptr if the list leaves it out.
+  const char* list_key;
+  // List key of the display name of a named value.
+  const char* list_name_key;
+  FdFieldGroup group;
+  FdFieldFormat format;
+  int flags;
+};
+
+namespace fd_fields {
+
+constexpr FdField kFd = {"fd", "fd", nullptr, FD_GROUP_ENTRY, FD_FORMAT_DECIMAL, 0};
+constexpr FdField kType = {"type", "fdType", "fdTypeName", FD_GROUP_ENTRY, FD_FORMAT_NAME, 0};
+constexpr FdField kSoType = {"so_type", "soType", nullptr, FD_GROUP_SOCKET, FD_FORMAT_DECIMAL, 0};
+constexpr FdField kSoProto = {"so_proto", "soProto", nullptr, FD_GROUP_SOCKET, FD_FORMAT_DECIMAL, 0};
+constexpr FdField kFamily = {"family", "family", nullptr, FD_GROUP_SOCKET, FD_FORMAT_DECIMAL, 0};
+constexpr FdField kOpenFlags = {"open", "openFlags", nullptr, FD_GROUP_ENTRY, FD_FORMAT_OPEN_FLAGS, FD_FIELD_NULLABLE};
+constexpr FdField kFdFlags = {"fdflag", "fdFlags", nullptr, FD_GROUP_ENTRY, FD_FORMAT_FD_FLAGS, FD_FIELD_NULLABLE};
+constexpr FdField kPath = {"path", "path", nullptr, FD_GROUP_ENTRY, FD_FORMAT_DECIMAL, FD_FIELD_NULLABLE};
+constexpr FdField kDev = {nullptr, "dev", nullptr, FD_GROUP_ENTRY, FD_FORMAT_DECIMAL, 0};
+constexpr FdField kInode = {nullptr, "inode", nullptr, FD_GROUP_ENTRY, FD_FORMAT_DECIMAL, 0};
+constexpr FdField kTorn = {"torn", "torn", nullptr, FD_GROUP_ENTRY, FD_FORMAT_DECIMAL, 0};
+constexpr FdField kLocal = {"local", "local", nullptr, FD_GROUP_SOCKET, FD_FORMAT_DECIMAL, FD_FIELD_NULLABLE};
+constexpr FdField kPeer = {"peer", "peer", nullptr, FD_GROUP_SOCKET, FD_FORMAT_DECIMAL, FD_FIELD_NULLABLE};
+constexpr FdField kTcpState = {"tcp_state", "tcpState", "tcpStateName", FD_GROUP_SOCKET, FD_FORMAT_NAME_AND_VALUE, 0};
+constexpr FdField kMode = {"mode", "mode", nullptr, FD_GROUP_VNODE, FD_FORMAT_OCTAL, 0};
+constexpr FdField kSize = {"size", "size", nullptr, FD_GROUP_VNODE, FD_FORMAT_DECIMAL, 0};
+constexpr FdField kNlink = {nullptr, "nlink", nullptr, FD_GROUP_VNODE, FD_FORMAT_DECIMAL, 0};
+constexpr FdField kDeleted = {"deleted", "deleted", nullptr, FD_GROUP_VNODE, FD_FORMAT_DECIMAL, 0};
+constexpr FdField kDiskBytes = {"disk_bytes", "diskBytes", nullptr, FD_GROUP_VNODE, FD_FORMAT_DECIMAL, 0};
+constexpr FdField kMapped = {nullptr, "mapped", nullptr, FD_GROUP_VNODE, FD_FORMAT_DECIMAL, 0};
+constexpr FdField kMappedBytes = {"mapped_bytes", "mappedBytes", nullptr, FD_GROUP_VNODE, FD_FORMAT_DECIMAL, 0};
+
+}  // namespace fd_fields
+
+// Encoder interface, by convention:
+//   void Int(const FdField&, long long value, bool in_list, bool in_text);
+//   void Bool(const FdField&, bool value, bool in_list, bool in_text);
+//   void String(const FdField&, const std::string& value, bool in_list, bool in_text);
+//   void Named(const FdField&, long long value, const std::string& name, bool in_list, bool in_text);
+// |in_list| / |in_text| say whether the field applies to this entry in each
+// output; the encoder still skips fields whose key is nullptr.
+template <typename Encoder>
+void VisitFdEntry(const FdEntry& e, Encoder* enc) {
+  using namespace fd_fields;
+  const SocketDetails& s = e.socket;
+  const VnodeDetails& v = e.vnode;
+  const bool socket = s.present;
+  const bool vnode = v.present;
+
+  enc->Int(kFd, e.fd, true, true);
+  enc->Named(kType, e.fd_type, e.fd_type_name, true, true);
+  enc->Int(kSoType, s.so_type, socket && s.has_so_type, socket && s.has_so_type);
+  enc->Int(kSoProto, s.so_proto, socket && s.has_so_proto, socket && s.has_so_proto);
+  enc->Int(kFamily, s.family, socket && s.has_family, socket && s.has_family);
+  enc->Int(kOpenFlags, e.open_flags, true, e.open_flags >= 0);
+  enc->Int(kFdFlags, e.fd_flags, true, e.fd_flags >= 0);
+  enc->String(kPath, e.path, true, !e.path.empty());
+  enc->Int(kDev, static_cast<long long>(e.dev), true, false);
+  enc->Int(kInode, static_cast<long long>(e.inode), true, false);
+  enc->Bool(kTorn, e.torn, e.torn, e.torn);
+  enc->String(kLocal, s.local, socket, socket && !s.local.empty());
+  enc->String(kPeer, s.peer, socket, socket && !s.peer.empty());
+  enc->Named(kTcpState, s.tcp_state, s.tcp_state_name, socket && s.has_tcp_state, socket && s.has_tcp_state);
+  enc->Int(kMode, v.mode, vnode, vnode);
+  enc->Int(kSize, v.size, vnode, vnode);
+  enc->Int(kNlink, v.nlink, vnode, false);
+  enc->Bool(kDeleted, v.deleted, vnode, vnode && v.deleted);
+  enc->Int(kDiskBytes, v.disk_bytes, vnode, vnode && v.deleted);
+  enc->Bool(kMapped, true, vnode && v.mapped, false);
+  enc->Int(kMappedBytes, v.mapped_bytes, vnode && v.mapped, vnode && v.mapped);
+}
+
+#endif  // FLUTTER_FD_UTILS_FD_ENTRY_SCHEMA_H_
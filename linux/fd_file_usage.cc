@@ -0,0 +1,182 @@
+#include "fd_file_usage.h"
+
+#include "fd_emergency_dump.h"
+#include "fd_table_ops.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <utility>
+
+static const char kDeletedSuffix[] = " (deleted)";
+
+static bool EndsWith(const std::string& s, const char* suffix) {
+  size_t n = std::strlen(suffix);
+  return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+// memfd and SysV shm objects show up as deleted files but live in memory.
+static bool IsMemfd(const std::string& path) {
+  return path.compare(0, 7, "/memfd:") == 0;
+}
+
+static bool IsMemoryBacked(const std::string& path) {
+  return IsMemfd(path) || path.compare(0, 9, "/SYSV0000") == 0 || path.compare(0, 8, "/dev/shm") == 0;
+}
+
+bool ReadProcMaps(std::vector<FileMapping>* out) {
+  FILE* f = OpenOwnedFile("/proc/self/maps", "re");
+  if (f == nullptr) {
+    FdEmergencyDumpNotifyErrno(errno);
+    return false;
+  }
+
+  char* line = nullptr;
+  size_t cap = 0;
+  while (getline(&line, &cap, f) > 0) {
+    unsigned long long start = 0;
+    unsigned long long end = 0;
+    unsigned long long offset = 0;
+    unsigned int major_id = 0;
+    unsigned int minor_id = 0;
+    unsigned long long inode = 0;
+    char perms[8];
+    int path_pos = 0;
+    if (std::sscanf(line, "%llx-%llx %7s %llx %x:%x %llu %n", &start, &end, perms, &offset, &major_id, &minor_id,
+                    &inode, &path_pos) < 7) {
+      continue;
+    }
+    if (inode == 0 || line[path_pos] != '/') {
+      continue;
+    }
+
+    FileMapping m;
+    m.dev = static_cast<unsigned long long>(makedev(major_id, minor_id));
+    m.inode = inode;
+    m.start = start;
+    m.end = end;
+    m.path = line + path_pos;
+    if (!m.path.empty() && m.path.back() == '\n') {
+      m.path.pop_back();
+    }
+    if (EndsWith(m.path, kDeletedSuffix)) {
+      m.deleted = true;
+      m.path.resize(m.path.size() - (sizeof(kDeletedSuffix) - 1));
+    }
+    out->push_back(std::move(m));
+  }
+
+  std::free(line);
+  CloseOwnedFile(f);
+  return true;
+}
+
+// Stats a file that has no descriptor. Deleted mappings can only be reached
+// through /proc/self/map_files, which may require CAP_CHECKPOINT_RESTORE.
+static bool StatMappedFile(const FileMapping& m, struct stat* st) {
+  if (!m.deleted && stat(m.path.c_str(), st) == 0 && st->st_ino == m.inode) {
+    return true;
+  }
+  char link[64];
+  std::snprintf(link, sizeof(link), "/proc/self/map_files/%llx-%llx", m.start, m.end);
+  return stat(link, st) == 0 && st->st_ino == m.inode;
+}
+
+FileUsageReport JoinFileUsage(std::vector<FdEntry>* entries, const std::vector<FileMapping>& mappings) {
+  FileUsageReport report;
+  std::map<std::pair<unsigned long long, unsigned long long>, size_t> index;
+
+  for (const auto& e : *entries) {
+    if (e.fd_type != FD_TYPE_VNODE || !e.vnode.present || !S_ISREG(static_cast<mode_t>(e.vnode.mode))) {
+      continue;
+    }
+    auto key = std::make_pair(e.dev, e.inode);
+    auto it = index.find(key);
+    if (it == index.end()) {
+      FileUsage u;
+      u.dev = e.dev;
+      u.inode = e.inode;
+      u.path = e.path;
+      if (EndsWith(u.path, kDeletedSuffix)) {
+        u.path.resize(u.path.size() - (sizeof(kDeletedSuffix) - 1));
+      }
+      u.deleted = e.vnode.deleted;
+      u.size = e.vnode.size;
+      u.disk_bytes = e.vnode.disk_bytes;
+      it = index.emplace(key, report.files.size()).first;
+      report.files.push_back(std::move(u));
+    }
+    report.files[it->second].fds.push_back(e.fd);
+  }
+
+  for (const auto& m : mappings) {
+    auto key = std::make_pair(m.dev, m.inode);
+    auto it = index.find(key);
+    if (it == index.end()) {
+      FileUsage u;
+      u.dev = m.dev;
+      u.inode = m.inode;
+      u.path = m.path;
+      u.state = FILE_USAGE_MAPPED_ONLY;
+      u.deleted = m.deleted;
+      struct stat st;
+      if (StatMappedFile(m, &st)) {
+        u.size = static_cast<long long>(st.st_size);
+        u.disk_bytes = static_cast<long long>(st.st_blocks) * 512;
+        u.deleted = st.st_nlink == 0;
+      }
+      it = index.emplace(key, report.files.size()).first;
+      report.files.push_back(std::move(u));
+    }
+    FileUsage& u = report.files[it->second];
+    if (u.state == FILE_USAGE_OPEN_ONLY) {
+      u.state = FILE_USAGE_OPEN_AND_MAPPED;
+    }
+    u.mapping_count++;
+    u.mapped_bytes += static_cast<long long>(m.end - m.start);
+  }
+
+  for (auto& u : report.files) {
+    // A memfd was never linked, so it is not a deleted file that closing
+    // would reclaim.
+    if (!u.deleted || IsMemfd(u.path)) {
+      continue;
+    }
+    report.deleted_file_count++;
+    if (u.disk_bytes > 0 && !IsMemoryBacked(u.path)) {
+      u.reclaimable_bytes = u.disk_bytes;
+      report.deleted_reclaimable_bytes += u.disk_bytes;
+    }
+  }
+
+  MarkMappedEntries(entries, mappings);
+  return report;
+}
+
+void MarkMappedEntries(std::vector<FdEntry>* entries, const std::vector<FileMapping>& mappings) {
+  std::map<std::pair<unsigned long long, unsigned long long>, long long> mapped_bytes;
+  for (const auto& m : mappings) {
+    mapped_bytes[std::make_pair(m.dev, m.inode)] += static_cast<long long>(m.end - m.start);
+  }
+  for (auto& e : *entries) {
+    if (e.fd_type != FD_TYPE_VNODE || !e.vnode.present) {
+      continue;
+    }
+    auto it = mapped_bytes.find(std::make_pair(e.dev, e.inode));
+    if (it != mapped_bytes.end()) {
+      e.vnode.mapped = true;
+      e.vnode.mapped_bytes = it->second;
+    }
+  }
+}
+
+FileUsageReport CollectFileUsage(std::vector<FdEntry>* entries) {
+  *entries = CollectFdList();
+  std::vector<FileMapping> mappings;
+  ReadProcMaps(&mappings);
+  return JoinFileUsage(entries, mappings);
+}
@@ -0,0 +1,68 @@
+#ifndef FLUTTER_FD_UTILS_FD_FILE_USAGE_H_
+#define FLUTTER_FD_UTILS_FD_FILE_USAGE_H_
+
+#include <string>
+#include <vector>
+
+#include "fd_collector.h"
+
+// Joins open descriptors with /proc/self/maps by (dev, inode) to find files
+// that are only open, only mapped, or both, and how much disk space deleted
+// ones still pin.
+
+// One file-backed line of /proc/self/maps.
+struct FileMapping {
+  unsigned long long dev = 0;
+  unsigned long long inode = 0;
+  unsigned long long start = 0;
+  unsigned long long end = 0;
+  std::string path;
+  bool deleted = false;
+};
+
+enum FileUsageState {
+  FILE_USAGE_OPEN_ONLY = 0,
+  FILE_USAGE_MAPPED_ONLY = 1,
+  FILE_USAGE_OPEN_AND_MAPPED = 2,
+};
+
+struct FileUsage {
+  unsigned long long dev = 0;
+  unsigned long long inode = 0;
+  std::string path;
+  FileUsageState state = FILE_USAGE_OPEN_ONLY;
+  bool deleted = false;
+  std::vector<int> fds;
+  int mapping_count = 0;
+  long long mapped_bytes = 0;
+  // -1 when the file could not be stat'ed (e.g. a deleted mapping whose
+  // map_files entry is not accessible).
+  long long size = -1;
+  long long disk_bytes = -1;
+  // Disk space freed once every descriptor and mapping is gone; 0 for files
+  // that are still linked and for memfd/shmem objects.
+  long long reclaimable_bytes = 0;
+};
+
+struct FileUsageReport {
+  std::vector<FileUsage> files;
+  // Totals over deleted files, not counting memfds.
+  long long deleted_reclaimable_bytes = 0;
+  long deleted_file_count = 0;
+};
+
+// Reads the file-backed mappings of the current process.
+bool ReadProcMaps(std::vector<FileMapping>* out);
+
+// Builds the per-file view and marks VnodeDetails::mapped / mapped_bytes on
+// the matching descriptors in |entries|.
+FileUsageReport JoinFileUsage(std::vector<FdEntry>* entries, const std::vector<FileMapping>& mappings);
+
+// Only sets VnodeDetails::mapped / mapped_bytes on the descriptors in
+// |entries| that are also mapped; cheap enough for every snapshot.
+void MarkMappedEntries(std::vector<FdEntry>* entries, const std::vector<FileMapping>& mappings);
+
+// Collects the fd table and the mappings back to back and joins them.
+FileUsageReport CollectFileUsage(std::vector<FdEntry>* entries);
+
+#endif  // FLUTTER_FD_UTILS_FD_FILE_USAGE_H_
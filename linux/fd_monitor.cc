@@ -0,0 +1,80 @@
+#include "fd_monitor.h"
+
+#include <algorithm>
+#include <vector>
+
+FdMonitor& FdMonitor::Instance() {
+  static FdMonitor* instance = new FdMonitor();
+  return *instance;
+}
+
+int FdMonitor::AddListener(std::chrono::milliseconds interval, Listener listener) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (interval < std::chrono::milliseconds(1)) {
+    interval = std::chrono::milliseconds(1);
+  }
+  int id = next_id_++;
+  listeners_[id] = Registration{interval, std::chrono::steady_clock::now(),
+                                std::make_shared<Listener>(std::move(listener))};
+  if (!thread_.joinable()) {
+    // Lives for the rest of the process, like the singleton itself.
+    thread_ = std::thread(&FdMonitor::Run, this);
+  }
+  changed_.notify_all();
+  return id;
+}
+
+void FdMonitor::RemoveListener(int id) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  listeners_.erase(id);
+  changed_.notify_all();
+  if (std::this_thread::get_id() != thread_.get_id()) {
+    changed_.wait(lock, [this] { return !dispatching_; });
+  }
+}
+
+void FdMonitor::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    if (listeners_.empty()) {
+      changed_.wait(lock);
+      continue;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    auto next_due = std::chrono::steady_clock::time_point::max();
+    std::chrono::milliseconds shortest = std::chrono::milliseconds::max();
+    for (const auto& kv : listeners_) {
+      next_due = std::min(next_due, kv.second.next_due);
+      shortest = std::min(shortest, kv.second.interval);
+    }
+    if (next_due > now) {
+      changed_.wait_until(lock, next_due);
+      continue;
+    }
+
+    std::vector<std::shared_ptr<Listener>> due;
+    for (auto& kv : listeners_) {
+      if (kv.second.next_due <= now) {
+        due.push_back(kv.second.listener);
+        // Skip missed ticks instead of bursting to catch up.
+        while (kv.second.next_due <= now) {
+          kv.second.next_due += kv.second.interval;
+        }
+      }
+    }
+    dispatching_ = true;
+    lock.unlock();
+
+    // A snapshot taken by any other caller within half an interval is fresh
+    // enough for a periodic sample.
+    auto snapshot = FdSnapshotCache::Instance().Get(shortest / 2);
+    for (const auto& listener : due) {
+      (*listener)(snapshot);
+    }
+
+    lock.lock();
+    dispatching_ = false;
+    changed_.notify_all();
+  }
+}
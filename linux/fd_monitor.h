@@ -0,0 +1,53 @@
+#ifndef FLUTTER_FD_UTILS_FD_MONITOR_H_
+#define FLUTTER_FD_UTILS_FD_MONITOR_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "fd_snapshot_cache.h"
+
+// Background sampler of the fd table.
+//
+// Consumers register a listener with their own interval; one monitor thread
+// takes a snapshot through FdSnapshotCache whenever a listener is due and
+// hands it to every listener that is due. The thread is started with the
+// first listener and idles while there are none.
+class FdMonitor {
+ public:
+  typedef std::function<void(const std::shared_ptr<const FdSnapshot>&)> Listener;
+
+  static FdMonitor& Instance();
+
+  // Registers |listener| to be called on the monitor thread every |interval|,
+  // starting immediately. Returns an id for RemoveListener().
+  int AddListener(std::chrono::milliseconds interval, Listener listener);
+
+  // Unregisters a listener. Once this returns the listener is not running and
+  // will not be called again, unless this is called from the listener itself.
+  void RemoveListener(int id);
+
+ private:
+  struct Registration {
+    std::chrono::milliseconds interval;
+    std::chrono::steady_clock::time_point next_due;
+    std::shared_ptr<Listener> listener;
+  };
+
+  FdMonitor() = default;
+
+  void Run();
+
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  std::map<int, Registration> listeners_;
+  int next_id_ = 1;
+  bool dispatching_ = false;
+  std::thread thread_;
+};
+
+#endif  // FLUTTER_FD_UTILS_FD_MONITOR_H_
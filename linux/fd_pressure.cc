@@ -0,0 +1,164 @@
+#include "fd_pressure.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "fd_collector.h"
+#include "fd_emergency_dump.h"
+#include "fd_table_ops.h"
+
+// Reads up to |n| whitespace-separated integers from a small proc file.
+static int ReadProcNumbers(const char* path, long long* values, int n) {
+  char buf[128];
+  int fd = OpenOwnedFd([path] { return open(path, O_RDONLY | O_CLOEXEC); });
+  if (fd < 0) {
+    FdEmergencyDumpNotifyErrno(errno);
+    return 0;
+  }
+  ssize_t len = read(fd, buf, sizeof(buf) - 1);
+  CloseOwnedFd(fd);
+  if (len <= 0) {
+    return 0;
+  }
+  buf[len] = '\0';
+
+  int parsed = 0;
+  char* p = buf;
+  while (parsed < n) {
+    char* end = nullptr;
+    long long v = std::strtoll(p, &end, 10);
+    if (end == p) break;
+    values[parsed++] = v;
+    p = end;
+  }
+  return parsed;
+}
+
+static long long ReadProcNumber(const char* path) {
+  long long v = -1;
+  ReadProcNumbers(path, &v, 1);
+  return v;
+}
+
+// Counts fdinfo lines starting with |prefix| (one per inotify watch or epoll
+// target).
+static long long CountFdinfoLines(int fd, const char* prefix) {
+  char path[64];
+  std::snprintf(path, sizeof(path), "/proc/self/fdinfo/%d", fd);
+  FILE* f = OpenOwnedFile(path, "re");
+  if (f == nullptr) {
+    FdEmergencyDumpNotifyErrno(errno);
+    return 0;
+  }
+  long long count = 0;
+  size_t prefix_len = std::strlen(prefix);
+  char line[512];
+  while (std::fgets(line, sizeof(line), f) != nullptr) {
+    if (std::strncmp(line, prefix, prefix_len) == 0) {
+      count++;
+    }
+  }
+  CloseOwnedFile(f);
+  return count;
+}
+
+// Only readlinkat() runs per descriptor; fdinfo is read just for the inotify
+// and epoll instances it finds.
+static void CountWatches(FdPressure* p) {
+  DIR* dir = OpenOwnedDir("/proc/self/fd");
+  if (dir == nullptr) {
+    FdEmergencyDumpNotifyErrno(errno);
+    return;
+  }
+  int own_fd = dirfd(dir);
+  char target[64];
+  struct dirent* ent;
+  while ((ent = readdir(dir)) != nullptr) {
+    if (ent->d_name[0] == '.') continue;
+    int fd = std::atoi(ent->d_name);
+    if (fd == own_fd) continue;
+
+    ssize_t len = readlinkat(own_fd, ent->d_name, target, sizeof(target) - 1);
+    if (len <= 0) continue;
+    target[len] = '\0';
+    if (std::strcmp(target, "anon_inode:inotify") == 0) {
+      p->inotify_instances++;
+      p->inotify_watches += CountFdinfoLines(fd, "inotify wd:");
+    } else if (std::strcmp(target, "anon_inode:[eventpoll]") == 0) {
+      p->epoll_instances++;
+      p->epoll_watches += CountFdinfoLines(fd, "tfd:");
+    }
+  }
+  CloseOwnedDir(dir);
+}
+
+struct CachedSysctls {
+  std::chrono::steady_clock::time_point read_at;
+  bool valid = false;
+  long long inotify_max_user_watches = -1;
+  long long inotify_max_user_instances = -1;
+  long long epoll_max_user_watches = -1;
+};
+
+static CachedSysctls ReadCachedSysctls(long ttl_ms) {
+  static std::mutex mutex;
+  static CachedSysctls cached;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto now = std::chrono::steady_clock::now();
+  if (!cached.valid || now - cached.read_at > std::chrono::milliseconds(ttl_ms)) {
+    cached.inotify_max_user_watches = ReadProcNumber("/proc/sys/fs/inotify/max_user_watches");
+    cached.inotify_max_user_instances = ReadProcNumber("/proc/sys/fs/inotify/max_user_instances");
+    cached.epoll_max_user_watches = ReadProcNumber("/proc/sys/fs/epoll/max_user_watches");
+    cached.read_at = now;
+    cached.valid = true;
+  }
+  return cached;
+}
+
+FdPressure ReadFdPressure(long sysctl_ttl_ms) {
+  FdPressure p;
+
+  long count = CountFds();
+  if (count >= 0) {
+    p.process_fds = count;
+  }
+  struct rlimit lim;
+  if (getrlimit(RLIMIT_NOFILE, &lim) == 0) {
+    p.nofile_soft = static_cast<long long>(lim.rlim_cur);
+    p.nofile_hard = static_cast<long long>(lim.rlim_max);
+  }
+
+  // file-nr: allocated, allocated-but-unused (always 0 since 2.6), max.
+  long long file_nr[3] = {-1, -1, -1};
+  if (ReadProcNumbers("/proc/sys/fs/file-nr", file_nr, 3) == 3) {
+    p.system_files_allocated = file_nr[0] - file_nr[1];
+    p.system_files_max = file_nr[2];
+  }
+
+  CachedSysctls sysctls = ReadCachedSysctls(sysctl_ttl_ms);
+  p.inotify_max_user_watches = sysctls.inotify_max_user_watches;
+  p.inotify_max_user_instances = sysctls.inotify_max_user_instances;
+  p.epoll_max_user_watches = sysctls.epoll_max_user_watches;
+
+  CountWatches(&p);
+  return p;
+}
+
+double HeadroomRatio(long long used, long long limit) {
+  if (used < 0 || limit <= 0) {
+    return -1;
+  }
+  double ratio = 1.0 - static_cast<double>(used) / static_cast<double>(limit);
+  if (ratio < 0) return 0;
+  if (ratio > 1) return 1;
+  return ratio;
+}
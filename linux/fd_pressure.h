@@ -0,0 +1,38 @@
+#ifndef FLUTTER_FD_UTILS_FD_PRESSURE_H_
+#define FLUTTER_FD_UTILS_FD_PRESSURE_H_
+
+// System-wide fd and watch limits next to this process's own usage.
+//
+// inotify and epoll limits are per user, so the process counts are a lower
+// bound on what counts against them. Values that could not be read are -1.
+
+struct FdPressure {
+  // RLIMIT_NOFILE and open descriptors of this process.
+  long long process_fds = -1;
+  long long nofile_soft = -1;
+  long long nofile_hard = -1;
+
+  // /proc/sys/fs/file-nr: allocated handles and fs.file-max.
+  long long system_files_allocated = -1;
+  long long system_files_max = -1;
+
+  // fs.inotify.max_user_{watches,instances} and this process's usage.
+  long long inotify_instances = 0;
+  long long inotify_watches = 0;
+  long long inotify_max_user_watches = -1;
+  long long inotify_max_user_instances = -1;
+
+  // fs.epoll.max_user_watches and this process's usage.
+  long long epoll_instances = 0;
+  long long epoll_watches = 0;
+  long long epoll_max_user_watches = -1;
+};
+
+// Reads the current pressure. The fs.inotify / fs.epoll maxima rarely change
+// and are re-read at most every |sysctl_ttl_ms| milliseconds.
+FdPressure ReadFdPressure(long sysctl_ttl_ms = 30000);
+
+// 1 - used / limit clamped to [0, 1], or -1 when either side is unknown.
+double HeadroomRatio(long long used, long long limit);
+
+#endif  // FLUTTER_FD_UTILS_FD_PRESSURE_H_
@@ -0,0 +1,323 @@
+#include "fd_report_stream.h"
+
+#include "fd_collector.h"
+#include "fd_entry_schema.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// Fills a fixed buffer and hands it to the sink whenever it is full.
+class ChunkWriter {
+ public:
+  ChunkWriter(size_t chunk_size, const FdReportChunkSink& sink, FdReportStreamStats* stats)
+      : sink_(sink), stats_(stats), ok_(true) {
+    buffer_.resize(chunk_size);
+    used_ = 0;
+  }
+
+  bool ok() const { return ok_; }
+
+  void Append(const std::string& s) {
+    const char* data = s.data();
+    size_t len = s.size();
+    while (ok_ && len > 0) {
+      size_t n = std::min(len, buffer_.size() - used_);
+      std::copy(data, data + n, buffer_.begin() + used_);
+      used_ += n;
+      data += n;
+      len -= n;
+      if (used_ == buffer_.size()) {
+        Flush();
+      }
+    }
+  }
+
+  void Flush() {
+    if (!ok_ || used_ == 0) {
+      return;
+    }
+    ok_ = sink_(buffer_.data(), used_);
+    stats_->bytes += static_cast<long long>(used_);
+    stats_->chunks++;
+    used_ = 0;
+  }
+
+ private:
+  const FdReportChunkSink& sink_;
+  FdReportStreamStats* stats_;
+  std::vector<char> buffer_;
+  size_t used_;
+  bool ok_;
+};
+
+}  // namespace
+
+// Length of the well-formed UTF-8 sequence at |p| (|n| bytes available), or
+// 0 if it is not one: stray continuation bytes, overlong forms, surrogates and
+// code points above U+10FFFF are all rejected.
+static size_t Utf8SequenceLength(const unsigned char* p, size_t n) {
+  unsigned char c = p[0];
+  size_t len;
+  unsigned char lo = 0x80;
+  unsigned char hi = 0xBF;
+  if (c >= 0xC2 && c <= 0xDF) {
+    len = 2;
+  } else if (c >= 0xE0 && c <= 0xEF) {
+    len = 3;
+    if (c == 0xE0) lo = 0xA0;
+    if (c == 0xED) hi = 0x9F;
+  } else if (c >= 0xF0 && c <= 0xF4) {
+    len = 4;
+    if (c == 0xF0) lo = 0x90;
+    if (c == 0xF4) hi = 0x8F;
+  } else {
+    return 0;
+  }
+  if (n < len || p[1] < lo || p[1] > hi) {
+    return 0;
+  }
+  for (size_t i = 2; i < len; i++) {
+    if (p[i] < 0x80 || p[i] > 0xBF) {
+      return 0;
+    }
+  }
+  return len;
+}
+
+void AppendJsonString(std::string* out, const std::string& s) {
+  out->push_back('"');
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(s.data());
+  size_t n = s.size();
+  for (size_t i = 0; i < n;) {
+    unsigned char c = bytes[i];
+    if (c >= 0x80) {
+      // Paths are arbitrary bytes on Linux. Valid UTF-8 is copied; any other
+      // byte becomes \u00XX so the output stays valid JSON.
+      size_t len = Utf8SequenceLength(bytes + i, n - i);
+      if (len > 0) {
+        out->append(s, i, len);
+        i += len;
+      } else {
+        char esc[8];
+        std::snprintf(esc, sizeof(esc), "\\u%04x", c);
+        out->append(esc);
+        i++;
+      }
+      continue;
+    }
+    switch (c) {
+      case '"':
+        out->append("\\\"");
+        break;
+      case '\\':
+        out->append("\\\\");
+        break;
+      case '\n':
+        out->append("\\n");
+        break;
+      case '\r':
+        out->append("\\r");
+        break;
+      case '\t':
+        out->append("\\t");
+        break;
+      default:
+        if (c < 0x20) {
+          char esc[8];
+          std::snprintf(esc, sizeof(esc), "\\u%04x", c);
+          out->append(esc);
+        } else {
+          out->push_back(static_cast<char>(c));
+        }
+    }
+    i++;
+  }
+  out->push_back('"');
+}
+
+namespace {
+
+void AppendKey(std::string* out, const char* key) {
+  if (out->back() != '{') {
+    out->push_back(',');
+  }
+  out->push_back('"');
+  out->append(key);
+  out->append("\":");
+}
+
+void AppendInt(std::string* out, const char* key, long long v) {
+  AppendKey(out, key);
+  out->append(std::to_string(v));
+}
+
+void AppendBool(std::string* out, const char* key, bool v) {
+  AppendKey(out, key);
+  out->append(v ? "true" : "false");
+}
+
+void AppendString(std::string* out, const char* key, const std::string& v) {
+  AppendKey(out, key);
+  AppendJsonString(out, v);
+}
+
+// Renders the fields of fd_entry_schema.h as a JSON object with the same keys
+// and nesting as a getFdList entry. Socket and vnode fields are collected in
+// their own buffers, since the schema interleaves them with entry fields, and
+// appended by Finish().
+class FdJsonEncoder {
+ public:
+  explicit FdJsonEncoder(std::string* out) : out_(out) {}
+
+  void Int(const FdField& f, long long value, bool in_list, bool) {
+    if (!in_list || f.list_key == nullptr) return;
+    bool null = (f.flags & FD_FIELD_NULLABLE) != 0 && value < 0;
+    std::string* out = Target(f.group);
+    AppendKey(out, f.list_key);
+    out->append(null ? "null" : std::to_string(value));
+  }
+
+  void Bool(const FdField& f, bool value, bool in_list, bool) {
+    if (!in_list || f.list_key == nullptr) return;
+    AppendBool(Target(f.group), f.list_key, value);
+  }
+
+  void String(const FdField& f, const std::string& value, bool in_list, bool) {
+    if (!in_list || f.list_key == nullptr) return;
+    std::string* out = Target(f.group);
+    AppendKey(out, f.list_key);
+    if ((f.flags & FD_FIELD_NULLABLE) != 0 && value.empty()) {
+      out->append("null");
+    } else {
+      AppendJsonString(out, value);
+    }
+  }
+
+  void Named(const FdField& f, long long value, const std::string& name, bool in_list, bool) {
+    if (!in_list || f.list_key == nullptr) return;
+    std::string* out = Target(f.group);
+    AppendInt(out, f.list_key, value);
+    if (f.list_name_key != nullptr) {
+      AppendString(out, f.list_name_key, name);
+    }
+  }
+
+  // Closes the nested objects and the record.
+  void Finish() {
+    AppendNested("socket", socket_);
+    AppendNested("vnode", vnode_);
+    out_->append("}\n");
+  }
+
+ private:
+  std::string* Target(FdFieldGroup group) {
+    switch (group) {
+      case FD_GROUP_SOCKET:
+        return Nested(&socket_);
+      case FD_GROUP_VNODE:
+        return Nested(&vnode_);
+      default:
+        return out_;
+    }
+  }
+
+  static std::string* Nested(std::string* s) {
+    if (s->empty()) s->push_back('{');
+    return s;
+  }
+
+  void AppendNested(const char* key, const std::string& s) {
+    if (s.empty()) return;
+    AppendKey(out_, key);
+    out_->append(s);
+    out_->push_back('}');
+  }
+
+  std::string* out_;
+  std::string socket_;
+  std::string vnode_;
+};
+
+void RenderFdRecord(const FdEntry& e, std::string* out) {
+  out->assign("{");
+  AppendString(out, "type", "fd");
+  FdJsonEncoder encoder(out);
+  VisitFdEntry(e, &encoder);
+  encoder.Finish();
+}
+
+}  // namespace
+
+FdReportStreamStats StreamFdReport(const FdReportStreamOptions& options, const FdReportChunkSink& sink) {
+  FdReportStreamStats stats;
+  ChunkWriter writer(options.chunk_size > 0 ? options.chunk_size : 1, sink, &stats);
+
+  std::string record = "{";
+  AppendString(&record, "type", "header");
+  AppendInt(&record, "pid", getpid());
+  AppendString(&record, "timestampUtc", Iso8601Now());
+  struct rlimit lim;
+  if (getrlimit(RLIMIT_NOFILE, &lim) == 0) {
+    AppendInt(&record, "nofileSoft", static_cast<long long>(lim.rlim_cur));
+    AppendInt(&record, "nofileHard", static_cast<long long>(lim.rlim_max));
+  }
+  AppendInt(&record, "chunkSize", static_cast<long long>(options.chunk_size));
+  record.append("}\n");
+  writer.Append(record);
+
+  long long type_counts[FD_TYPE_PIPE + 1] = {0};
+  long long format_ns = 0;
+  FdCollectOptions collect;
+  collect.cancelled = options.cancelled;
+  FdCollectResult result = ForEachFd(collect, [&](FdEntry& e) {
+    long long start = MonotonicNowNs();
+    RenderFdRecord(e, &record);
+    format_ns += MonotonicNowNs() - start;
+    writer.Append(record);
+    stats.fd_count++;
+    if (e.fd_type >= 0 && e.fd_type <= FD_TYPE_PIPE) {
+      type_counts[e.fd_type]++;
+    }
+    return writer.ok();
+  });
+  FdCollectorStats::Instance().RecordPhase(FD_PHASE_FORMAT, format_ns);
+  if (!writer.ok()) {
+    return stats;
+  }
+  stats.cancelled = result.cancelled;
+  result.timings.ns[FD_PHASE_FORMAT] = format_ns;
+
+  record = "{";
+  AppendString(&record, "type", "summary");
+  AppendInt(&record, "fdCount", stats.fd_count);
+  AppendKey(&record, "typeCounts");
+  record.push_back('{');
+  for (int type : {FD_TYPE_UNKNOWN, FD_TYPE_VNODE, FD_TYPE_SOCKET, FD_TYPE_PIPE}) {
+    if (type_counts[type] > 0) {
+      AppendInt(&record, FdTypeName(type), type_counts[type]);
+    }
+  }
+  record.push_back('}');
+  AppendKey(&record, "timingsNs");
+  record.push_back('{');
+  for (int phase = 0; phase < FD_PHASE_COUNT; phase++) {
+    if (result.timings.ns[phase] > 0) {
+      AppendInt(&record, FdPhaseName(phase), result.timings.ns[phase]);
+    }
+  }
+  record.push_back('}');
+  AppendBool(&record, "cancelled", stats.cancelled);
+  if (result.next_fd >= 0) {
+    AppendInt(&record, "nextFd", result.next_fd);
+  }
+  record.append("}\n");
+  writer.Append(record);
+  writer.Flush();
+  return stats;
+}
@@ -0,0 +1,49 @@
+#ifndef FLUTTER_FD_UTILS_FD_REPORT_STREAM_H_
+#define FLUTTER_FD_UTILS_FD_REPORT_STREAM_H_
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <string>
+
+// Streaming NDJSON form of the fd report.
+//
+// The output is one JSON object per line:
+//   {"type":"header","pid":..,"timestampUtc":..,"nofileSoft":..,...}
+//   {"type":"fd","fd":3,"fdType":1,"fdTypeName":"VNODE",...}   (one per fd)
+//   {"type":"summary","fdCount":..,"typeCounts":{..},"timingsNs":{..},...}
+//
+// Fd records are rendered from fd_entry_schema.h and carry the same keys and
+// nesting as a getFdList entry.
+//
+// Descriptors are probed one at a time and rendered straight into a single
+// chunk buffer, so peak memory is the chunk size plus one record regardless of
+// how many descriptors are open. A record may span two chunks; consumers
+// split the concatenated stream on '\n'.
+
+struct FdReportStreamOptions {
+  // Bytes handed to the sink per call (the last chunk may be shorter).
+  size_t chunk_size = 64 * 1024;
+  // Polled between descriptors; setting it ends the stream early with a
+  // summary marked cancelled.
+  const std::atomic<bool>* cancelled = nullptr;
+};
+
+struct FdReportStreamStats {
+  long long fd_count = 0;
+  long long bytes = 0;
+  long long chunks = 0;
+  bool cancelled = false;
+};
+
+// Receives each filled chunk. The data is only valid during the call.
+// Returning false abandons the stream without a summary.
+typedef std::function<bool(const char* data, size_t len)> FdReportChunkSink;
+
+// Appends |s| to |out| as a quoted JSON string. Bytes that are not part of
+// valid UTF-8 are written as \u00XX escapes.
+void AppendJsonString(std::string* out, const std::string& s);
+
+FdReportStreamStats StreamFdReport(const FdReportStreamOptions& options, const FdReportChunkSink& sink);
+
+#endif  // FLUTTER_FD_UTILS_FD_REPORT_STREAM_H_
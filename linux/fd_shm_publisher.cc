@@ -0,0 +1,198 @@
+#include "fd_shm_publisher.h"
+
+#include "include/flutter_fd_utils/flutter_fd_utils_shm.h"
+
+#include "fd_collector.h"
+#include "fd_emergency_dump.h"
+#include "fd_monitor.h"
+#include "fd_table_ops.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static_assert(sizeof(FlutterFdUtilsShmHeader) == 256, "shm header layout changed");
+static_assert(sizeof(FlutterFdUtilsShmEntry) == 32, "shm entry layout changed");
+
+namespace {
+
+constexpr size_t kMaxCapacity = 1 << 20;
+
+struct Publisher {
+  FdShmPublisherInfo info;
+  std::string shm_name;
+  void* base = nullptr;
+  int listener_id = 0;
+};
+
+// Guards g_publisher against concurrent start/stop. Publishing itself only
+// runs on the monitor thread, and Stop() removes the listener before
+// unmapping.
+std::mutex g_mutex;
+Publisher* g_publisher = nullptr;
+
+int CreateSegment(const std::string& name) {
+  if (name.empty()) {
+#ifdef SYS_memfd_create
+    return static_cast<int>(syscall(SYS_memfd_create, "flutter_fd_utils_shm", MFD_CLOEXEC));
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+  }
+  // Never reuse an existing object: truncating one that a reader still has
+  // mapped would make its next access SIGBUS.
+  return shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+}
+
+void Publish(Publisher* p, const FdSnapshot& snapshot) {
+  FlutterFdUtilsShmHeader* header = static_cast<FlutterFdUtilsShmHeader*>(p->base);
+  FlutterFdUtilsShmEntry* entries =
+      reinterpret_cast<FlutterFdUtilsShmEntry*>(static_cast<char*>(p->base) + header->header_size);
+
+  FdTypeCounts counts = CountFdTypes(snapshot.entries);
+  struct rlimit lim;
+  bool have_lim = getrlimit(RLIMIT_NOFILE, &lim) == 0;
+  struct timespec wall;
+  clock_gettime(CLOCK_REALTIME, &wall);
+  long long collect_ns = 0;
+  for (int phase = FD_PHASE_DIR_SCAN; phase <= FD_PHASE_SOCKET_PROBE; phase++) {
+    collect_ns += snapshot.timings.ns[phase];
+  }
+  long long age_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - snapshot.captured_at)
+                         .count();
+
+  // Seqlock write: odd sequence, release fence, payload, even sequence.
+  uint64_t seq = __atomic_load_n(&header->sequence, __ATOMIC_RELAXED);
+  __atomic_store_n(&header->sequence, seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  header->publish_count++;
+  header->captured_monotonic_ns = MonotonicNowNs() - age_ns;
+  header->published_unix_ms = static_cast<int64_t>(wall.tv_sec) * 1000 + wall.tv_nsec / 1000000;
+  header->collect_ns = collect_ns;
+  header->fd_count = static_cast<int64_t>(snapshot.entries.size());
+  header->vnode_count = counts.vnode;
+  header->socket_count = counts.socket;
+  header->pipe_count = counts.pipe;
+  header->unknown_count = counts.unknown;
+  header->non_cloexec_count = counts.non_cloexec;
+  header->nofile_soft = have_lim ? static_cast<int64_t>(lim.rlim_cur) : -1;
+  header->nofile_hard = have_lim ? static_cast<int64_t>(lim.rlim_max) : -1;
+
+  size_t n = std::min(snapshot.entries.size(), p->info.capacity);
+  for (size_t i = 0; i < n; i++) {
+    const FdEntry& e = snapshot.entries[i];
+    FlutterFdUtilsShmEntry& out = entries[i];
+    out.fd = e.fd;
+    out.fd_type = e.fd_type;
+    out.open_flags = e.open_flags;
+    out.fd_flags = e.fd_flags;
+    out.dev = e.dev;
+    out.inode = e.inode;
+  }
+  header->entry_count = n;
+
+  __atomic_store_n(&header->sequence, seq + 2, __ATOMIC_RELEASE);
+}
+
+void Destroy(Publisher* p) {
+  if (p->base != nullptr) {
+    munmap(p->base, p->info.segment_size);
+  }
+  if (p->info.fd >= 0) {
+    CloseOwnedFd(p->info.fd);
+  }
+  if (!p->shm_name.empty()) {
+    shm_unlink(p->shm_name.c_str());
+  }
+  delete p;
+}
+
+}  // namespace
+
+bool FdShmPublisherStart(const FdShmPublisherConfig& config, FdShmPublisherInfo* info, int* out_errno) {
+  FdShmPublisherStop();
+
+  size_t capacity = std::min(std::max<size_t>(config.capacity, 1), kMaxCapacity);
+  size_t size = sizeof(FlutterFdUtilsShmHeader) + capacity * sizeof(FlutterFdUtilsShmEntry);
+
+  int fd = OpenOwnedFd([&config] { return CreateSegment(config.name); });
+  if (fd < 0) {
+    if (out_errno != nullptr) *out_errno = errno;
+    FdEmergencyDumpNotifyErrno(errno);
+    return false;
+  }
+  Publisher* p = new Publisher();
+  p->info.fd = fd;
+  p->shm_name = config.name;
+  p->info.segment_size = size;
+  p->info.capacity = capacity;
+  p->info.interval = config.interval;
+  p->info.path = config.name.empty()
+                     ? "/proc/" + std::to_string(getpid()) + "/fd/" + std::to_string(fd)
+                     : "/dev/shm" + (config.name[0] == '/' ? config.name : "/" + config.name);
+
+  if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    if (out_errno != nullptr) *out_errno = errno;
+    Destroy(p);
+    return false;
+  }
+  void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (base == MAP_FAILED) {
+    if (out_errno != nullptr) *out_errno = errno;
+    Destroy(p);
+    return false;
+  }
+  p->base = base;
+
+  // The segment is zero-filled by ftruncate, so sequence starts at 0 ("not
+  // yet published") while the immutable fields are filled in.
+  FlutterFdUtilsShmHeader* header = static_cast<FlutterFdUtilsShmHeader*>(base);
+  header->layout_version = FLUTTER_FD_UTILS_SHM_LAYOUT_VERSION;
+  header->header_size = sizeof(FlutterFdUtilsShmHeader);
+  header->entry_size = sizeof(FlutterFdUtilsShmEntry);
+  header->segment_size = size;
+  header->pid = getpid();
+  header->capacity = capacity;
+  __atomic_store_n(&header->magic, FLUTTER_FD_UTILS_SHM_MAGIC, __ATOMIC_RELEASE);
+
+  p->info.active = true;
+  {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_publisher = p;
+  }
+  // The first call happens immediately on the monitor thread.
+  p->listener_id = FdMonitor::Instance().AddListener(
+      config.interval, [p](const std::shared_ptr<const FdSnapshot>& snapshot) { Publish(p, *snapshot); });
+
+  if (info != nullptr) *info = p->info;
+  return true;
+}
+
+void FdShmPublisherStop() {
+  Publisher* p = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    p = g_publisher;
+    g_publisher = nullptr;
+  }
+  if (p == nullptr) {
+    return;
+  }
+  FdMonitor::Instance().RemoveListener(p->listener_id);
+  Destroy(p);
+}
+
+FdShmPublisherInfo FdShmPublisherGetInfo() {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  return g_publisher != nullptr ? g_publisher->info : FdShmPublisherInfo();
+}
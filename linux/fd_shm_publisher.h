@@ -0,0 +1,42 @@
+#ifndef FLUTTER_FD_UTILS_FD_SHM_PUBLISHER_H_
+#define FLUTTER_FD_UTILS_FD_SHM_PUBLISHER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+// Opt-in publication of fd summaries and a compact snapshot into shared
+// memory, refreshed by FdMonitor. The segment layout and the seqlock reader
+// protocol are documented in include/flutter_fd_utils/flutter_fd_utils_shm.h.
+
+struct FdShmPublisherConfig {
+  // shm_open(3) name such as "/my_app.fds"; starting fails with EEXIST if an
+  // object of that name already exists. Empty creates an anonymous memfd
+  // instead, readable through /proc/<pid>/fd/<n>.
+  std::string name;
+  std::chrono::milliseconds interval{1000};
+  // Maximum number of entries in the segment.
+  size_t capacity = 4096;
+};
+
+struct FdShmPublisherInfo {
+  bool active = false;
+  // Path an external reader should open.
+  std::string path;
+  int fd = -1;
+  size_t segment_size = 0;
+  size_t capacity = 0;
+  std::chrono::milliseconds interval{0};
+};
+
+// Creates and maps the segment, publishes a first snapshot and registers with
+// the monitor. Replaces any running publisher. Returns false and sets
+// |out_errno| if the segment cannot be created.
+bool FdShmPublisherStart(const FdShmPublisherConfig& config, FdShmPublisherInfo* info, int* out_errno);
+
+// Stops refreshing, unmaps the segment and unlinks a named shm object.
+void FdShmPublisherStop();
+
+FdShmPublisherInfo FdShmPublisherGetInfo();
+
+#endif  // FLUTTER_FD_UTILS_FD_SHM_PUBLISHER_H_
@@ -0,0 +1,96 @@
+#include "fd_snapshot_cache.h"
+
+#include "fd_file_usage.h"
+
+#include <utility>
+
+// Snapshots carry the mapping state of each descriptor, so the list and the
+// report can show it without a separate getFileUsage call.
+static void MarkMappings(std::vector<FdEntry>* entries) {
+  std::vector<FileMapping> mappings;
+  if (ReadProcMaps(&mappings)) {
+    MarkMappedEntries(entries, mappings);
+  }
+}
+
+FdSnapshotCache& FdSnapshotCache::Instance() {
+  static FdSnapshotCache* cache = new FdSnapshotCache();
+  return *cache;
+}
+
+std::shared_ptr<const FdSnapshot> FdSnapshotCache::Get(std::chrono::milliseconds max_age) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    if (latest_ && std::chrono::steady_clock::now() - latest_->captured_at <= max_age) {
+      return latest_;
+    }
+    if (!collecting_) {
+      break;
+    }
+    // Single flight: join the collection that is already running. If it
+    // fails, |collecting_| drops without a new generation and this thread
+    // tries again.
+    uint64_t waiting_for = generation_ + 1;
+    collected_.wait(lock, [&] { return generation_ >= waiting_for || !collecting_; });
+    if (generation_ >= waiting_for) {
+      return collected_snapshot_;
+    }
+  }
+
+  collecting_ = true;
+  lock.unlock();
+
+  auto snapshot = std::make_shared<FdSnapshot>();
+  try {
+    FdCollectResult collected = CollectFdList(FdCollectOptions());
+    snapshot->entries = std::move(collected.entries);
+    snapshot->timings = collected.timings;
+    MarkMappings(&snapshot->entries);
+  } catch (...) {
+    lock.lock();
+    collecting_ = false;
+    lock.unlock();
+    collected_.notify_all();
+    throw;
+  }
+  snapshot->captured_at = std::chrono::steady_clock::now();
+
+  lock.lock();
+  latest_ = snapshot;
+  collected_snapshot_ = snapshot;
+  collecting_ = false;
+  generation_++;
+  lock.unlock();
+  collected_.notify_all();
+  return snapshot;
+}
+
+std::shared_ptr<const FdSnapshot> FdSnapshotCache::Get() {
+  return Get(default_max_age());
+}
+
+void FdSnapshotCache::SetDefaultMaxAge(std::chrono::milliseconds max_age) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  default_max_age_ = max_age;
+}
+
+std::chrono::milliseconds FdSnapshotCache::default_max_age() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return default_max_age_;
+}
+
+void FdSnapshotCache::Store(std::vector<FdEntry> entries, const FdPhaseTimings& timings) {
+  auto snapshot = std::make_shared<FdSnapshot>();
+  snapshot->entries = std::move(entries);
+  snapshot->timings = timings;
+  MarkMappings(&snapshot->entries);
+  snapshot->captured_at = std::chrono::steady_clock::now();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  latest_ = std::move(snapshot);
+}
+
+void FdSnapshotCache::Invalidate() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  latest_.reset();
+}
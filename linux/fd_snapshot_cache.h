@@ -0,0 +1,62 @@
+#ifndef FLUTTER_FD_UTILS_FD_SNAPSHOT_CACHE_H_
+#define FLUTTER_FD_UTILS_FD_SNAPSHOT_CACHE_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "fd_collector.h"
+
+// One CollectFdList() result shared by every consumer that asked for it.
+struct FdSnapshot {
+  // VnodeDetails::mapped / mapped_bytes are filled in from /proc/self/maps.
+  std::vector<FdEntry> entries;
+  std::chrono::steady_clock::time_point captured_at;
+  // Collection phases of the pass that produced |entries|.
+  FdPhaseTimings timings;
+};
+
+// Process-wide cache of the most recent snapshot.
+//
+// Callers that can accept data up to |max_age| old are served from the cache;
+// callers that miss while a collection is already running wait for it instead
+// of starting their own, so N concurrent requests cost one collection.
+class FdSnapshotCache {
+ public:
+  static FdSnapshotCache& Instance();
+
+  // Returns a snapshot no older than |max_age|, or the result of a collection
+  // that was in flight when the call was made.
+  std::shared_ptr<const FdSnapshot> Get(std::chrono::milliseconds max_age);
+
+  // Same as Get() using the configured default maximum age.
+  std::shared_ptr<const FdSnapshot> Get();
+
+  void SetDefaultMaxAge(std::chrono::milliseconds max_age);
+  std::chrono::milliseconds default_max_age();
+
+  // Publishes the result of a full pass made outside the cache.
+  void Store(std::vector<FdEntry> entries, const FdPhaseTimings& timings = FdPhaseTimings());
+
+  // Drops the cached snapshot; the next Get() always collects.
+  void Invalidate();
+
+ private:
+  FdSnapshotCache() = default;
+
+  std::mutex mutex_;
+  std::condition_variable collected_;
+  std::shared_ptr<const FdSnapshot> latest_;
+  // Result of the most recent collection made by Get(). Threads that joined
+  // it return this rather than |latest_|, which Invalidate() may have reset
+  // by the time they wake up.
+  std::shared_ptr<const FdSnapshot> collected_snapshot_;
+  std::chrono::milliseconds default_max_age_{0};
+  bool collecting_ = false;
+  uint64_t generation_ = 0;
+};
+
+#endif  // FLUTTER_FD_UTILS_FD_SNAPSHOT_CACHE_H_
@@ -0,0 +1,242 @@
+#include "fd_table_ops.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <dirent.h>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+#ifndef __NR_close_range
+#define __NR_close_range 436
+#endif
+#ifndef CLOSE_RANGE_CLOEXEC
+#define CLOSE_RANGE_CLOEXEC (1U << 2)
+#endif
+
+// Guards the owned-descriptor list and is held across CloseRange().
+static std::mutex& OwnedMutex() {
+  static std::mutex* mutex = new std::mutex();
+  return *mutex;
+}
+
+static std::vector<int>& OwnedFds() {
+  static auto* fds = new std::vector<int>();
+  return *fds;
+}
+
+static int SysCloseRange(unsigned int first, unsigned int last, unsigned int flags) {
+  return static_cast<int>(syscall(__NR_close_range, first, last, flags));
+}
+
+// Lists open descriptors in [first, last], excluding the one used to list
+// them. Collected up front so the fallback never mutates the table it reads.
+static bool ListOpenFds(unsigned int first, unsigned int last, std::vector<int>* out, int* err) {
+  DIR* dir = opendir("/proc/self/fd");
+  if (dir == nullptr) {
+    *err = errno;
+    return false;
+  }
+  int own_fd = dirfd(dir);
+  struct dirent* ent;
+  while ((ent = readdir(dir)) != nullptr) {
+    if (ent->d_name[0] == '.') {
+      continue;
+    }
+    long fd = std::strtol(ent->d_name, nullptr, 10);
+    if (fd < 0 || fd == own_fd) {
+      continue;
+    }
+    if (static_cast<unsigned long>(fd) >= first && static_cast<unsigned long>(fd) <= last) {
+      out->push_back(static_cast<int>(fd));
+    }
+  }
+  closedir(dir);
+  return true;
+}
+
+// close_range reports EINVAL for unknown flags and ENOSYS when missing
+// entirely (or filtered by seccomp); both mean "use the fallback".
+static bool ShouldFallBack(int err) {
+  return err == ENOSYS || err == EINVAL || err == EPERM;
+}
+
+FdRangeResult SetCloexecRange(unsigned int first, unsigned int last) {
+  FdRangeResult result;
+  if (first > last) {
+    result.err = EINVAL;
+    return result;
+  }
+
+  if (SysCloseRange(first, last, CLOSE_RANGE_CLOEXEC) == 0) {
+    result.success = true;
+    result.used_close_range = true;
+    return result;
+  }
+  if (!ShouldFallBack(errno)) {
+    result.err = errno;
+    return result;
+  }
+
+  std::vector<int> fds;
+  if (!ListOpenFds(first, last, &fds, &result.err)) {
+    return result;
+  }
+  result.affected = 0;
+  for (int fd : fds) {
+    int flags = fcntl(fd, F_GETFD);
+    if (flags < 0 || (flags & FD_CLOEXEC) != 0) {
+      continue;
+    }
+    if (fcntl(fd, F_SETFD, flags | FD_CLOEXEC) == 0) {
+      result.affected++;
+    } else if (result.err == 0 && errno != EBADF) {
+      result.err = errno;
+    }
+  }
+  result.success = result.err == 0;
+  return result;
+}
+
+// CloseRange() of a piece that holds no owned descriptor.
+static FdRangeResult CloseRangeUnowned(unsigned int first, unsigned int last) {
+  FdRangeResult result;
+  if (SysCloseRange(first, last, 0) == 0) {
+    result.success = true;
+    result.used_close_range = true;
+    return result;
+  }
+  if (!ShouldFallBack(errno)) {
+    result.err = errno;
+    return result;
+  }
+
+  std::vector<int> fds;
+  if (!ListOpenFds(first, last, &fds, &result.err)) {
+    return result;
+  }
+  result.affected = 0;
+  for (int fd : fds) {
+    // Linux releases the descriptor even when close() reports EINTR.
+    if (close(fd) == 0 || errno == EINTR) {
+      result.affected++;
+    }
+  }
+  result.success = true;
+  return result;
+}
+
+FdRangeResult CloseRange(unsigned int first, unsigned int last) {
+  FdRangeResult result;
+  if (first > last) {
+    result.err = EINVAL;
+    return result;
+  }
+
+  std::lock_guard<std::mutex> lock(OwnedMutex());
+  std::vector<int> owned = OwnedFds();
+  std::sort(owned.begin(), owned.end());
+
+  // Close each gap between owned descriptors. The result uses close_range
+  // only if every piece did; |affected| then stays -1.
+  result.success = true;
+  result.used_close_range = true;
+  long affected = 0;
+  unsigned long long lo = first;
+  auto close_piece = [&](unsigned int piece_first, unsigned int piece_last) {
+    FdRangeResult piece = CloseRangeUnowned(piece_first, piece_last);
+    if (!piece.success) {
+      result.success = false;
+      if (result.err == 0) result.err = piece.err;
+    }
+    if (piece.used_close_range) {
+      return;
+    }
+    result.used_close_range = false;
+    affected += piece.affected >= 0 ? piece.affected : 0;
+  };
+  for (int fd : owned) {
+    unsigned long long owned_fd = static_cast<unsigned int>(fd);
+    if (fd < 0 || owned_fd < lo || owned_fd > last) {
+      continue;
+    }
+    if (owned_fd > lo) {
+      close_piece(static_cast<unsigned int>(lo), static_cast<unsigned int>(owned_fd - 1));
+    }
+    lo = owned_fd + 1;
+  }
+  if (lo <= last) {
+    close_piece(static_cast<unsigned int>(lo), last);
+  }
+  result.affected = result.used_close_range ? -1 : affected;
+  return result;
+}
+
+int OpenOwnedFd(const std::function<int()>& open_fd) {
+  std::lock_guard<std::mutex> lock(OwnedMutex());
+  int fd = open_fd();
+  if (fd >= 0) {
+    int saved_errno = errno;
+    OwnedFds().push_back(fd);
+    errno = saved_errno;
+  }
+  return fd;
+}
+
+// Drops |fd| from the owned list; the caller holds OwnedMutex() and closes it
+// before letting go, so the number cannot be reused while still listed.
+static void UnregisterOwnedFd(int fd) {
+  std::vector<int>& owned = OwnedFds();
+  auto it = std::find(owned.begin(), owned.end(), fd);
+  if (it != owned.end()) {
+    owned.erase(it);
+  }
+}
+
+void CloseOwnedFd(int fd) {
+  if (fd < 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(OwnedMutex());
+  UnregisterOwnedFd(fd);
+  close(fd);
+}
+
+DIR* OpenOwnedDir(const char* path) {
+  DIR* dir = nullptr;
+  OpenOwnedFd([&] {
+    dir = opendir(path);
+    return dir != nullptr ? dirfd(dir) : -1;
+  });
+  return dir;
+}
+
+void CloseOwnedDir(DIR* dir) {
+  if (dir == nullptr) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(OwnedMutex());
+  UnregisterOwnedFd(dirfd(dir));
+  closedir(dir);
+}
+
+FILE* OpenOwnedFile(const char* path, const char* mode) {
+  FILE* file = nullptr;
+  OpenOwnedFd([&] {
+    file = std::fopen(path, mode);
+    return file != nullptr ? fileno(file) : -1;
+  });
+  return file;
+}
+
+void CloseOwnedFile(FILE* file) {
+  if (file == nullptr) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(OwnedMutex());
+  UnregisterOwnedFd(fileno(file));
+  std::fclose(file);
+}
@@ -0,0 +1,50 @@
+#ifndef FLUTTER_FD_UTILS_FD_TABLE_OPS_H_
+#define FLUTTER_FD_UTILS_FD_TABLE_OPS_H_
+
+#include <cstdio>
+#include <dirent.h>
+#include <functional>
+
+// Bulk operations on the process fd table.
+//
+// Both operations use close_range(2) when the kernel supports it (5.9 for
+// closing, 5.11 for CLOSE_RANGE_CLOEXEC) and otherwise fall back to walking
+// /proc/self/fd, so only descriptors that are actually open are touched.
+
+struct FdRangeResult {
+  bool success = false;
+  bool used_close_range = false;
+  // Descriptors touched by the fallback loop; -1 when close_range was used.
+  long affected = -1;
+  int err = 0;
+};
+
+// Sets FD_CLOEXEC on every open descriptor in [first, last].
+FdRangeResult SetCloexecRange(unsigned int first, unsigned int last);
+
+// Closes every open descriptor in [first, last] except the plugin's own (see
+// OpenOwnedFd()); the range is split around them.
+FdRangeResult CloseRange(unsigned int first, unsigned int last);
+
+// Descriptors the plugin opens, both those it keeps across calls (emergency
+// dump file and directory, trace output, shm segment, io_uring ring) and the
+// short-lived ones of background calls (/proc listings, the sock_diag socket,
+// proc files). |open_fd| runs under
+// the same lock as CloseRange(), so a concurrent closeRange can neither close
+// the new descriptor nor run between its creation and its registration.
+// Returns what |open_fd| returned; negative results are not registered and
+// errno is preserved. Owned descriptors are all close-on-exec already, so
+// SetCloexecRange() does not need to skip them.
+int OpenOwnedFd(const std::function<int()>& open_fd);
+
+// Unregisters and closes a descriptor from OpenOwnedFd().
+void CloseOwnedFd(int fd);
+
+// OpenOwnedFd() for a directory stream or a stdio file; nullptr on failure,
+// with errno set. Release them with CloseOwnedDir() / CloseOwnedFile().
+DIR* OpenOwnedDir(const char* path);
+void CloseOwnedDir(DIR* dir);
+FILE* OpenOwnedFile(const char* path, const char* mode);
+void CloseOwnedFile(FILE* file);
+
+#endif  // FLUTTER_FD_UTILS_FD_TABLE_OPS_H_
@@ -0,0 +1,370 @@
+#include "fd_trace_exporter.h"
+
+#include "fd_collector.h"
+#include "fd_emergency_dump.h"
+#include "fd_monitor.h"
+#include "fd_report_stream.h"
+#include "fd_table_ops.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdint>
+#include <fcntl.h>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr size_t kFlushThreshold = 64 * 1024;
+
+// What a descriptor referred to in the previous sample. Anonymous inodes
+// (eventfd, timerfd, ...) all share one inode, so those are told apart by
+// their link text as well.
+struct TracedFd {
+  int fd;
+  int fd_type;
+  unsigned long long dev;
+  unsigned long long inode;
+  size_t path_hash;
+  uint64_t slice_id;
+};
+
+struct Exporter {
+  int fd = -1;
+  long long pid = 0;
+  // Pending output; flushed after every sample and whenever it grows past
+  // kFlushThreshold.
+  std::string buffer;
+  bool first_event = true;
+  bool sampled = false;
+  // Sorted by fd, like the snapshots.
+  std::vector<TracedFd> open;
+  uint64_t next_slice_id = 1;
+  // Set once the closing bracket has been written or a write failed; later
+  // samples are ignored.
+  bool finished = false;
+  std::atomic<int> listener_id{0};
+
+  std::mutex info_mutex;
+  FdTraceInfo info;
+};
+
+// Guards g_exporter against concurrent start/stop. Samples are only written
+// on the monitor thread, and Stop() removes the listener before finishing
+// the file.
+std::mutex g_mutex;
+Exporter* g_exporter = nullptr;
+
+long long TraceMicros(std::chrono::steady_clock::time_point t) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(t.time_since_epoch()).count();
+}
+
+size_t PathHash(const FdEntry& e) {
+  return e.fd_type == FD_TYPE_UNKNOWN ? std::hash<std::string>()(e.path) : 0;
+}
+
+bool SameObject(const TracedFd& t, const FdEntry& e) {
+  return t.fd_type == e.fd_type && t.dev == e.dev && t.inode == e.inode && t.path_hash == PathHash(e);
+}
+
+void Flush(Exporter* p) {
+  if (p->fd < 0) {
+    p->buffer.clear();
+    return;
+  }
+  size_t off = 0;
+  while (off < p->buffer.size()) {
+    ssize_t n = write(p->fd, p->buffer.data() + off, p->buffer.size() - off);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      int err = errno;
+      CloseOwnedFd(p->fd);
+      p->fd = -1;
+      p->finished = true;
+      std::lock_guard<std::mutex> lock(p->info_mutex);
+      p->info.write_errno = err;
+      break;
+    }
+    off += static_cast<size_t>(n);
+  }
+  {
+    std::lock_guard<std::mutex> lock(p->info_mutex);
+    p->info.bytes_written += static_cast<long long>(off);
+  }
+  p->buffer.clear();
+}
+
+// Starts an event object; the caller appends further keys and the closing
+// brace.
+void BeginEvent(Exporter* p, const char* ph, const std::string& name, long long ts) {
+  if (!p->first_event) {
+    p->buffer.append(",\n");
+  }
+  p->first_event = false;
+  p->buffer.append("{\"ph\":\"");
+  p->buffer.append(ph);
+  p->buffer.append("\",\"name\":");
+  AppendJsonString(&p->buffer, name);
+  p->buffer.append(",\"pid\":");
+  p->buffer.append(std::to_string(p->pid));
+  p->buffer.append(",\"tid\":");
+  p->buffer.append(std::to_string(p->pid));
+  p->buffer.append(",\"ts\":");
+  p->buffer.append(std::to_string(ts));
+}
+
+void AppendSliceId(Exporter* p, uint64_t id) {
+  char hex[24];
+  std::snprintf(hex, sizeof(hex), "0x%llx", static_cast<unsigned long long>(id));
+  p->buffer.append(",\"cat\":\"fd\",\"id\":\"");
+  p->buffer.append(hex);
+  p->buffer.append("\"");
+}
+
+void EmitSliceBegin(Exporter* p, const FdEntry& e, long long ts, bool at_start) {
+  TracedFd t = {e.fd, e.fd_type, e.dev, e.inode, PathHash(e), p->next_slice_id++};
+  p->open.push_back(t);
+  BeginEvent(p, "b", "fd " + std::to_string(e.fd), ts);
+  AppendSliceId(p, t.slice_id);
+  p->buffer.append(",\"args\":{\"type\":");
+  AppendJsonString(&p->buffer, e.fd_type_name);
+  p->buffer.append(",\"path\":");
+  AppendJsonString(&p->buffer, e.path);
+  p->buffer.append(",\"cloexec\":");
+  p->buffer.append(e.fd_flags >= 0 && (e.fd_flags & FD_CLOEXEC) != 0 ? "true" : "false");
+  if (at_start) {
+    p->buffer.append(",\"openAtStart\":true");
+  }
+  p->buffer.append("}}");
+}
+
+void EmitSliceEnd(Exporter* p, const TracedFd& t, long long ts) {
+  BeginEvent(p, "e", "fd " + std::to_string(t.fd), ts);
+  AppendSliceId(p, t.slice_id);
+  p->buffer.append("}");
+}
+
+void EmitCounter(Exporter* p, const char* name, long long ts,
+                 std::initializer_list<std::pair<const char*, long long>> values) {
+  BeginEvent(p, "C", name, ts);
+  p->buffer.append(",\"args\":{");
+  bool first = true;
+  for (const auto& v : values) {
+    if (!first) p->buffer.push_back(',');
+    first = false;
+    p->buffer.push_back('"');
+    p->buffer.append(v.first);
+    p->buffer.append("\":");
+    p->buffer.append(std::to_string(v.second));
+  }
+  p->buffer.append("}}");
+}
+
+void Finish(Exporter* p, long long ts) {
+  if (p->finished) {
+    return;
+  }
+  for (const TracedFd& t : p->open) {
+    EmitSliceEnd(p, t, ts);
+  }
+  {
+    std::lock_guard<std::mutex> lock(p->info_mutex);
+    p->info.closed += static_cast<long long>(p->open.size());
+  }
+  p->open.clear();
+  p->buffer.append("\n]\n");
+  Flush(p);
+  p->finished = true;
+  if (p->fd >= 0) {
+    CloseOwnedFd(p->fd);
+    p->fd = -1;
+  }
+}
+
+void Sample(Exporter* p, const FdSnapshot& snapshot) {
+  if (p->finished) {
+    return;
+  }
+  long long ts = TraceMicros(snapshot.captured_at);
+  bool at_start = !p->sampled;
+  p->sampled = true;
+
+  // Both sides are sorted by fd, so one merge pass finds what went away,
+  // what is new, and numbers that now refer to a different object.
+  std::vector<TracedFd> previous;
+  previous.swap(p->open);
+  p->open.reserve(snapshot.entries.size());
+  long long counts[FD_TYPE_PIPE + 1] = {0};
+  long long total = 0;
+  long long non_cloexec = 0;
+  long long opened = 0;
+  long long closed = 0;
+  size_t i = 0;
+  for (const FdEntry& e : snapshot.entries) {
+    if (e.fd == p->fd) {
+      // The trace file itself.
+      continue;
+    }
+    while (i < previous.size() && previous[i].fd < e.fd) {
+      EmitSliceEnd(p, previous[i++], ts);
+      closed++;
+    }
+    if (i < previous.size() && previous[i].fd == e.fd) {
+      if (SameObject(previous[i], e)) {
+        p->open.push_back(previous[i++]);
+      } else {
+        EmitSliceEnd(p, previous[i++], ts);
+        closed++;
+        EmitSliceBegin(p, e, ts, false);
+        opened++;
+      }
+    } else {
+      EmitSliceBegin(p, e, ts, at_start);
+      opened++;
+    }
+
+    total++;
+    if (e.fd_type >= 0 && e.fd_type <= FD_TYPE_PIPE) {
+      counts[e.fd_type]++;
+    }
+    if (e.fd_flags >= 0 && (e.fd_flags & FD_CLOEXEC) == 0) {
+      non_cloexec++;
+    }
+    if (p->buffer.size() >= kFlushThreshold) {
+      Flush(p);
+    }
+  }
+  for (; i < previous.size(); i++) {
+    EmitSliceEnd(p, previous[i], ts);
+    closed++;
+  }
+
+  EmitCounter(p, "fd types", ts,
+              {{"vnode", counts[FD_TYPE_VNODE]},
+               {"socket", counts[FD_TYPE_SOCKET]},
+               {"pipe", counts[FD_TYPE_PIPE]},
+               {"unknown", counts[FD_TYPE_UNKNOWN]}});
+  EmitCounter(p, "fd total", ts, {{"fds", total}, {"non_cloexec", non_cloexec}});
+  EmitCounter(p, "fd churn", ts, {{"opened", at_start ? 0 : opened}, {"closed", closed}});
+  Flush(p);
+
+  bool over_limit = false;
+  {
+    std::lock_guard<std::mutex> lock(p->info_mutex);
+    p->info.samples++;
+    p->info.opened += opened;
+    p->info.closed += closed;
+    over_limit = p->info.max_bytes > 0 && p->info.bytes_written >= p->info.max_bytes;
+    if (over_limit) {
+      p->info.truncated = true;
+    }
+  }
+  if (over_limit) {
+    Finish(p, ts);
+  }
+  if (p->finished) {
+    int id = p->listener_id.load();
+    if (id != 0) {
+      FdMonitor::Instance().RemoveListener(id);
+    }
+    std::lock_guard<std::mutex> lock(p->info_mutex);
+    p->info.active = false;
+  }
+}
+
+std::string ProcessName() {
+  char comm[64] = {0};
+  int fd = OpenOwnedFd([] { return open("/proc/self/comm", O_RDONLY | O_CLOEXEC); });
+  if (fd < 0) {
+    FdEmergencyDumpNotifyErrno(errno);
+  } else {
+    ssize_t n = read(fd, comm, sizeof(comm) - 1);
+    CloseOwnedFd(fd);
+    if (n > 0 && comm[n - 1] == '\n') {
+      comm[n - 1] = '\0';
+    }
+  }
+  return comm;
+}
+
+}  // namespace
+
+bool FdTraceStart(const FdTraceConfig& config, FdTraceInfo* info, int* out_errno) {
+  FdTraceStop();
+
+  int fd = OpenOwnedFd([&config] { return open(config.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644); });
+  if (fd < 0) {
+    if (out_errno != nullptr) *out_errno = errno;
+    FdEmergencyDumpNotifyErrno(errno);
+    return false;
+  }
+  Exporter* p = new Exporter();
+  p->fd = fd;
+  p->pid = getpid();
+  p->info.active = true;
+  p->info.path = config.path;
+  p->info.interval = config.interval;
+  p->info.max_bytes = config.max_bytes > 0 ? config.max_bytes : 0;
+
+  p->buffer.append("[\n");
+  BeginEvent(p, "M", "process_name", 0);
+  p->buffer.append(",\"args\":{\"name\":");
+  AppendJsonString(&p->buffer, ProcessName());
+  p->buffer.append("}}");
+  Flush(p);
+  if (p->finished) {
+    if (out_errno != nullptr) *out_errno = p->info.write_errno;
+    delete p;
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_exporter = p;
+  }
+  if (info != nullptr) {
+    std::lock_guard<std::mutex> lock(p->info_mutex);
+    *info = p->info;
+  }
+  // The first call happens immediately on the monitor thread.
+  p->listener_id = FdMonitor::Instance().AddListener(
+      config.interval, [p](const std::shared_ptr<const FdSnapshot>& snapshot) { Sample(p, *snapshot); });
+  return true;
+}
+
+FdTraceInfo FdTraceStop() {
+  Exporter* p = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    p = g_exporter;
+    g_exporter = nullptr;
+  }
+  if (p == nullptr) {
+    return FdTraceInfo();
+  }
+  FdMonitor::Instance().RemoveListener(p->listener_id.load());
+  Finish(p, TraceMicros(std::chrono::steady_clock::now()));
+  FdTraceInfo info;
+  {
+    std::lock_guard<std::mutex> lock(p->info_mutex);
+    info = p->info;
+  }
+  info.active = false;
+  delete p;
+  return info;
+}
+
+FdTraceInfo FdTraceGetInfo() {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  if (g_exporter == nullptr) {
+    return FdTraceInfo();
+  }
+  std::lock_guard<std::mutex> info_lock(g_exporter->info_mutex);
+  return g_exporter->info;
+}
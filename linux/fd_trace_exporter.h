@@ -0,0 +1,59 @@
+#ifndef FLUTTER_FD_UTILS_FD_TRACE_EXPORTER_H_
+#define FLUTTER_FD_UTILS_FD_TRACE_EXPORTER_H_
+
+#include <chrono>
+#include <string>
+
+// Records the sampled fd table as a Chrome trace-event JSON file, loadable in
+// chrome://tracing and ui.perfetto.dev.
+//
+// Every FdMonitor sample appends counter events ("fd types", "fd total",
+// "fd churn") and, by diffing against the previous sample, one async slice per
+// descriptor lifetime on a track named "fd <n>": a "b" event when a
+// descriptor (or a different object behind a reused number) first shows up
+// and an "e" event when it is gone. Lifetimes are only as precise as the
+// sampling interval; a descriptor opened and closed between two samples is
+// not seen.
+//
+// The file uses the JSON array format, written incrementally: events go
+// through a small buffer that is flushed after every sample, and the only
+// other state is the previous sample's identity per open fd. Stopping closes
+// the open slices and the array; a trace cut short by a crash is still
+// accepted by both viewers.
+
+struct FdTraceConfig {
+  std::string path;
+  std::chrono::milliseconds interval{1000};
+  // Stop recording once the file reaches this size; 0 for no limit.
+  long long max_bytes = 0;
+};
+
+struct FdTraceInfo {
+  bool active = false;
+  std::string path;
+  std::chrono::milliseconds interval{0};
+  long long max_bytes = 0;
+  long long bytes_written = 0;
+  long long samples = 0;
+  // Slices begun and ended so far.
+  long long opened = 0;
+  long long closed = 0;
+  // Recording stopped early because max_bytes was reached.
+  bool truncated = false;
+  // errno of a failed write, which also stops recording.
+  int write_errno = 0;
+};
+
+// Creates |config.path| (truncating it), writes the trace preamble and
+// registers with the monitor; the first sample is taken immediately.
+// Replaces any running trace. Returns false and sets |out_errno| if the file
+// cannot be created.
+bool FdTraceStart(const FdTraceConfig& config, FdTraceInfo* info, int* out_errno);
+
+// Ends the open slices, finishes the file and returns its final statistics.
+// Returns an inactive FdTraceInfo if no trace was running.
+FdTraceInfo FdTraceStop();
+
+FdTraceInfo FdTraceGetInfo();
+
+#endif  // FLUTTER_FD_UTILS_FD_TRACE_EXPORTER_H_
@@ -0,0 +1,309 @@
+#include "fd_unix_peers.h"
+
+#include "fd_emergency_dump.h"
+#include "fd_table_ops.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/sock_diag.h>
+#include <linux/unix_diag.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+constexpr std::chrono::seconds SocketInodeIndex::kNegativeTtl;
+
+namespace {
+
+// Parses "socket:[12345]".
+bool ParseSocketLink(const char* link, unsigned long long* inode) {
+  if (std::strncmp(link, "socket:[", 8) != 0) {
+    return false;
+  }
+  char* end = nullptr;
+  *inode = std::strtoull(link + 8, &end, 10);
+  return end != link + 8 && *end == ']';
+}
+
+std::string ReadComm(int pid) {
+  char path[64];
+  std::snprintf(path, sizeof(path), "/proc/%d/comm", pid);
+  int fd = OpenOwnedFd([&path] { return open(path, O_RDONLY | O_CLOEXEC); });
+  if (fd < 0) {
+    FdEmergencyDumpNotifyErrno(errno);
+    return std::string();
+  }
+  char buf[64];
+  ssize_t n = read(fd, buf, sizeof(buf));
+  CloseOwnedFd(fd);
+  if (n <= 0) {
+    return std::string();
+  }
+  if (buf[n - 1] == '\n') n--;
+  return std::string(buf, static_cast<size_t>(n));
+}
+
+// Lists numeric entries of /proc.
+std::vector<int> ListPids() {
+  std::vector<int> pids;
+  DIR* dir = OpenOwnedDir("/proc");
+  if (dir == nullptr) {
+    FdEmergencyDumpNotifyErrno(errno);
+    return pids;
+  }
+  struct dirent* ent;
+  while ((ent = readdir(dir)) != nullptr) {
+    if (ent->d_name[0] >= '1' && ent->d_name[0] <= '9') {
+      pids.push_back(std::atoi(ent->d_name));
+    }
+  }
+  CloseOwnedDir(dir);
+  return pids;
+}
+
+}  // namespace
+
+int QueryUnixSocketPeers(std::unordered_map<unsigned long long, unsigned long long>* peers) {
+  int nl = OpenOwnedFd([] { return socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG); });
+  if (nl < 0) {
+    int err = errno;
+    FdEmergencyDumpNotifyErrno(err);
+    return err;
+  }
+
+  struct {
+    struct nlmsghdr nlh;
+    struct unix_diag_req req;
+  } request;
+  std::memset(&request, 0, sizeof(request));
+  request.nlh.nlmsg_len = sizeof(request);
+  request.nlh.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+  request.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+  request.req.sdiag_family = AF_UNIX;
+  request.req.udiag_states = static_cast<__u32>(-1);
+  request.req.udiag_show = UDIAG_SHOW_PEER;
+
+  if (send(nl, &request, sizeof(request), 0) < 0) {
+    int err = errno;
+    CloseOwnedFd(nl);
+    return err;
+  }
+
+  alignas(struct nlmsghdr) char buf[32 * 1024];
+  int err = 0;
+  bool done = false;
+  while (!done) {
+    ssize_t len = recv(nl, buf, sizeof(buf), 0);
+    if (len < 0) {
+      if (errno == EINTR) continue;
+      err = errno;
+      break;
+    }
+    if (len == 0) {
+      break;
+    }
+    for (struct nlmsghdr* h = reinterpret_cast<struct nlmsghdr*>(buf); NLMSG_OK(h, static_cast<unsigned int>(len));
+         h = NLMSG_NEXT(h, len)) {
+      if (h->nlmsg_type == NLMSG_DONE) {
+        done = true;
+        break;
+      }
+      if (h->nlmsg_type == NLMSG_ERROR) {
+        const struct nlmsgerr* e = static_cast<const struct nlmsgerr*>(NLMSG_DATA(h));
+        err = e->error < 0 ? -e->error : EIO;
+        done = true;
+        break;
+      }
+      const struct unix_diag_msg* msg = static_cast<const struct unix_diag_msg*>(NLMSG_DATA(h));
+      int attr_len = static_cast<int>(h->nlmsg_len - NLMSG_LENGTH(sizeof(*msg)));
+      for (struct rtattr* attr = reinterpret_cast<struct rtattr*>(const_cast<struct unix_diag_msg*>(msg) + 1);
+           RTA_OK(attr, attr_len); attr = RTA_NEXT(attr, attr_len)) {
+        if (attr->rta_type == UNIX_DIAG_PEER && RTA_PAYLOAD(attr) >= sizeof(__u32)) {
+          __u32 peer;
+          std::memcpy(&peer, RTA_DATA(attr), sizeof(peer));
+          (*peers)[msg->udiag_ino] = peer;
+        }
+      }
+    }
+  }
+
+  CloseOwnedFd(nl);
+  return err;
+}
+
+SocketInodeIndex& SocketInodeIndex::Instance() {
+  static SocketInodeIndex* instance = new SocketInodeIndex();
+  return *instance;
+}
+
+void SocketInodeIndex::ScanProcess(int pid) {
+  char path[64];
+  std::snprintf(path, sizeof(path), "/proc/%d/fd", pid);
+  DIR* dir = OpenOwnedDir(path);
+  if (dir == nullptr) {
+    FdEmergencyDumpNotifyErrno(errno);
+    return;
+  }
+  int dir_fd = dirfd(dir);
+
+  std::string comm;
+  char link[64];
+  struct dirent* ent;
+  while ((ent = readdir(dir)) != nullptr) {
+    if (ent->d_name[0] == '.') continue;
+    ssize_t n = readlinkat(dir_fd, ent->d_name, link, sizeof(link) - 1);
+    if (n <= 0) continue;
+    link[n] = '\0';
+    unsigned long long inode = 0;
+    if (!ParseSocketLink(link, &inode)) continue;
+
+    if (comm.empty()) {
+      comm = ReadComm(pid);
+    }
+    Owner& owner = owners_[inode];
+    owner.pid = pid;
+    owner.fd = std::atoi(ent->d_name);
+    owner.comm = comm;
+  }
+  CloseOwnedDir(dir);
+}
+
+bool SocketInodeIndex::Verify(unsigned long long inode, Owner* owner) {
+  char path[64];
+  std::snprintf(path, sizeof(path), "/proc/%d/fd/%d", owner->pid, owner->fd);
+  char link[64];
+  ssize_t n = readlink(path, link, sizeof(link) - 1);
+  if (n <= 0) {
+    return false;
+  }
+  link[n] = '\0';
+  unsigned long long current = 0;
+  return ParseSocketLink(link, &current) && current == inode;
+}
+
+std::map<unsigned long long, SocketInodeIndex::Owner> SocketInodeIndex::Resolve(
+    const std::set<unsigned long long>& inodes, long* processes_scanned) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::map<unsigned long long, Owner> resolved;
+  std::set<unsigned long long> missing;
+  auto now = std::chrono::steady_clock::now();
+  long scanned = 0;
+
+  for (unsigned long long inode : inodes) {
+    auto it = owners_.find(inode);
+    if (it != owners_.end()) {
+      if (Verify(inode, &it->second)) {
+        resolved[inode] = it->second;
+        continue;
+      }
+      owners_.erase(it);
+    }
+    auto neg = unresolved_.find(inode);
+    if (neg != unresolved_.end() && now - neg->second < kNegativeTtl) {
+      continue;
+    }
+    missing.insert(inode);
+  }
+
+  auto take_found = [&]() {
+    for (auto it = missing.begin(); it != missing.end();) {
+      auto owner = owners_.find(*it);
+      if (owner != owners_.end()) {
+        resolved[*it] = owner->second;
+        unresolved_.erase(*it);
+        it = missing.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  };
+
+  if (!missing.empty()) {
+    std::vector<int> pids = ListPids();
+    std::set<int> alive(pids.begin(), pids.end());
+    for (auto it = scanned_pids_.begin(); it != scanned_pids_.end();) {
+      it = alive.count(*it) != 0 ? std::next(it) : scanned_pids_.erase(it);
+    }
+
+    // New processes are the likeliest holders of sockets we have not seen.
+    for (int pass = 0; pass < 2 && !missing.empty(); pass++) {
+      for (int pid : pids) {
+        bool known = scanned_pids_.count(pid) != 0;
+        if ((pass == 0) == known) continue;
+        ScanProcess(pid);
+        scanned_pids_.insert(pid);
+        scanned++;
+        take_found();
+        if (missing.empty()) break;
+      }
+    }
+
+    for (unsigned long long inode : missing) {
+      unresolved_[inode] = now;
+    }
+    // Keep the index bounded to sockets that still have a live owner.
+    for (auto it = owners_.begin(); it != owners_.end();) {
+      it = alive.count(it->second.pid) != 0 ? std::next(it) : owners_.erase(it);
+    }
+    for (auto it = unresolved_.begin(); it != unresolved_.end();) {
+      it = now - it->second >= kNegativeTtl ? unresolved_.erase(it) : std::next(it);
+    }
+  }
+
+  // comm can change (exec, prctl) without the socket moving.
+  for (auto& kv : resolved) {
+    std::string comm = ReadComm(kv.second.pid);
+    if (!comm.empty()) kv.second.comm = comm;
+  }
+
+  if (processes_scanned != nullptr) *processes_scanned = scanned;
+  return resolved;
+}
+
+void SocketInodeIndex::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  owners_.clear();
+  scanned_pids_.clear();
+  unresolved_.clear();
+}
+
+UnixPeerReport CollectUnixSocketPeers(const std::vector<FdEntry>& entries) {
+  UnixPeerReport report;
+  std::unordered_map<unsigned long long, unsigned long long> peers;
+  report.diag_errno = QueryUnixSocketPeers(&peers);
+
+  std::set<unsigned long long> wanted;
+  for (const auto& e : entries) {
+    if (e.fd_type != FD_TYPE_SOCKET || !e.socket.has_family || e.socket.family != AF_UNIX) {
+      continue;
+    }
+    UnixSocketPeer s;
+    s.fd = e.fd;
+    s.inode = e.inode;
+    s.local = e.socket.local;
+    auto it = peers.find(e.inode);
+    if (it != peers.end()) {
+      s.peer_inode = it->second;
+      wanted.insert(it->second);
+    }
+    report.sockets.push_back(std::move(s));
+  }
+
+  if (!wanted.empty()) {
+    auto owners = SocketInodeIndex::Instance().Resolve(wanted, &report.processes_scanned);
+    for (auto& s : report.sockets) {
+      auto it = owners.find(s.peer_inode);
+      if (it != owners.end()) {
+        s.peer_pid = it->second.pid;
+        s.peer_fd = it->second.fd;
+        s.peer_comm = it->second.comm;
+      }
+    }
+  }
+  return report;
+}
@@ -0,0 +1,87 @@
+#ifndef FLUTTER_FD_UTILS_FD_UNIX_PEERS_H_
+#define FLUTTER_FD_UTILS_FD_UNIX_PEERS_H_
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "fd_collector.h"
+
+// Resolves the other end of this process's unix sockets.
+//
+// The peer inode of every unix socket comes from one sock_diag netlink dump
+// (UNIX_DIAG_PEER). Peer inodes are mapped to the owning pid through a
+// system-wide socket-inode index built from /proc/*/fd.
+
+struct UnixSocketPeer {
+  int fd = -1;
+  unsigned long long inode = 0;
+  // e.g. "unix:/run/app.sock", "unix:@abstract" or "unix:(anonymous)".
+  std::string local;
+  // 0 when the socket is unconnected or sock_diag is unavailable.
+  unsigned long long peer_inode = 0;
+  // -1 when no readable /proc/<pid>/fd holds the peer.
+  int peer_pid = -1;
+  int peer_fd = -1;
+  std::string peer_comm;
+};
+
+struct UnixPeerReport {
+  std::vector<UnixSocketPeer> sockets;
+  // errno of the sock_diag query, or 0.
+  int diag_errno = 0;
+  // Processes whose fd tables were read to answer this call.
+  long processes_scanned = 0;
+};
+
+// Dumps every unix socket in the network namespace as inode -> peer inode.
+// Returns 0 or an errno value.
+int QueryUnixSocketPeers(std::unordered_map<unsigned long long, unsigned long long>* peers);
+
+// Process-wide cache of socket inode -> owning (pid, fd).
+//
+// Lookups are verified with a single readlink of the cached /proc/<pid>/fd/<n>.
+// Only inodes that miss trigger a scan, which visits processes not seen
+// before first, then previously scanned ones, and stops as soon as every
+// wanted inode is found. Inodes that could not be found are not searched for
+// again until kNegativeTtl has passed.
+class SocketInodeIndex {
+ public:
+  struct Owner {
+    int pid = -1;
+    int fd = -1;
+    std::string comm;
+  };
+
+  static constexpr std::chrono::seconds kNegativeTtl{5};
+
+  static SocketInodeIndex& Instance();
+
+  // Returns an owner for each inode of |inodes| that could be resolved.
+  // |processes_scanned| receives the number of fd tables read.
+  std::map<unsigned long long, Owner> Resolve(const std::set<unsigned long long>& inodes, long* processes_scanned);
+
+  void Clear();
+
+ private:
+  SocketInodeIndex() = default;
+
+  // Requires mutex_. Indexes every socket held by |pid|.
+  void ScanProcess(int pid);
+  // Requires mutex_. Checks a cached owner still holds |inode|.
+  bool Verify(unsigned long long inode, Owner* owner);
+
+  std::mutex mutex_;
+  std::unordered_map<unsigned long long, Owner> owners_;
+  std::set<int> scanned_pids_;
+  std::unordered_map<unsigned long long, std::chrono::steady_clock::time_point> unresolved_;
+};
+
+// Resolves the peers of the unix sockets among |entries|.
+UnixPeerReport CollectUnixSocketPeers(const std::vector<FdEntry>& entries);
+
+#endif  // FLUTTER_FD_UTILS_FD_UNIX_PEERS_H_
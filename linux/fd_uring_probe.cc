@@ -0,0 +1,374 @@
+#include "fd_uring_probe.h"
+
+#include "fd_emergency_dump.h"
+#include "fd_table_ops.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// Four SQEs per descriptor (statx, openat, read, close), so this probes 1024
+// descriptors per batch.
+constexpr unsigned kRingEntries = 4096;
+constexpr unsigned kSqesPerFd = 4;
+constexpr int kPending = INT_MIN;
+
+enum SlotOp { kStat = 0, kOpen = 1, kRead = 2, kClose = 3 };
+
+// 0 = not tried yet, 1 = works, -1 = unavailable.
+std::atomic<int> g_state{0};
+
+// The prober kept between passes; never destroyed, like the other
+// process-wide state.
+std::mutex g_idle_mutex;
+FdUringProber* g_idle = nullptr;
+
+uint64_t UserData(size_t slot, SlotOp op) {
+  return (static_cast<uint64_t>(slot) << 2) | op;
+}
+
+// Parses the octal "flags:" line of a /proc/<pid>/fdinfo/N file.
+bool ParseFdinfoFlags(const char* text, int* open_flags, int* fd_flags) {
+  const char* line = std::strstr(text, "flags:");
+  if (line == nullptr) {
+    return false;
+  }
+  char* end = nullptr;
+  long flags = std::strtol(line + 6, &end, 8);
+  if (end == line + 6) {
+    return false;
+  }
+  *open_flags = static_cast<int>(flags & ~static_cast<long>(O_CLOEXEC));
+  *fd_flags = (flags & O_CLOEXEC) != 0 ? FD_CLOEXEC : 0;
+  return true;
+}
+
+void StatFromStatx(const struct statx& stx, struct stat* st) {
+  std::memset(st, 0, sizeof(*st));
+  st->st_dev = makedev(stx.stx_dev_major, stx.stx_dev_minor);
+  st->st_ino = static_cast<ino_t>(stx.stx_ino);
+  st->st_mode = stx.stx_mode;
+  st->st_nlink = stx.stx_nlink;
+  st->st_size = static_cast<off_t>(stx.stx_size);
+  st->st_blocks = static_cast<blkcnt_t>(stx.stx_blocks);
+}
+
+}  // namespace
+
+struct FdUringProber::Slot {
+  char info_path[48];
+  struct statx stx;
+  // Only the first two lines (pos, flags) are needed.
+  char info[256];
+  int stat_res;
+  int open_res;
+  int read_res;
+  int close_res;
+};
+
+std::unique_ptr<FdUringProber> FdUringProber::Create() {
+  if (g_state.load(std::memory_order_relaxed) < 0) {
+    return nullptr;
+  }
+  std::unique_ptr<FdUringProber> prober(new FdUringProber());
+  if (!prober->Setup(kRingEntries)) {
+    g_state.store(-1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  g_state.store(1, std::memory_order_relaxed);
+  return prober;
+}
+
+FdUringProber::Lease FdUringProber::Acquire() {
+  {
+    std::lock_guard<std::mutex> lock(g_idle_mutex);
+    if (g_idle != nullptr) {
+      Lease lease(g_idle);
+      g_idle = nullptr;
+      return lease;
+    }
+  }
+  return Lease(Create().release());
+}
+
+void FdUringProber::Releaser::operator()(FdUringProber* prober) const {
+  if (!prober->failed_) {
+    std::lock_guard<std::mutex> lock(g_idle_mutex);
+    if (g_idle == nullptr) {
+      g_idle = prober;
+      return;
+    }
+  }
+  delete prober;
+}
+
+bool FdUringProber::Available() {
+  if (g_state.load(std::memory_order_relaxed) == 0) {
+    Acquire();
+  }
+  return g_state.load(std::memory_order_relaxed) > 0;
+}
+
+FdUringProber::~FdUringProber() {
+  if (failed_) {
+    // Requests that were still in flight point into the slots, and the kernel
+    // tears the ring down asynchronously; leave them allocated.
+    slots_.release();
+  }
+  if (sqes_ != nullptr) {
+    munmap(sqes_, sqes_size_);
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_ != nullptr) {
+    munmap(sq_ring_, sq_ring_size_);
+  }
+  if (ring_fd_ >= 0) {
+    CloseOwnedFd(ring_fd_);
+  }
+}
+
+bool FdUringProber::Setup(unsigned entries) {
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register)
+  struct io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  int fd = OpenOwnedFd([&] { return static_cast<int>(syscall(__NR_io_uring_setup, entries, &params)); });
+  if (fd < 0) {
+    FdEmergencyDumpNotifyErrno(errno);
+    return false;
+  }
+  ring_fd_ = fd;
+  sq_entries_ = params.sq_entries;
+  cq_entries_ = params.cq_entries;
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  void* sq = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (sq == MAP_FAILED) {
+    return false;
+  }
+  sq_ring_ = sq;
+  if (single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    void* cq = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (cq == MAP_FAILED) {
+      return false;
+    }
+    cq_ring_ = cq;
+  }
+  sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    return false;
+  }
+  sqes_ = sqes;
+
+  char* sq_base = static_cast<char*>(sq_ring_);
+  char* cq_base = static_cast<char*>(cq_ring_);
+  sq_tail_ = reinterpret_cast<unsigned*>(sq_base + params.sq_off.tail);
+  sq_mask_ = *reinterpret_cast<unsigned*>(sq_base + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned*>(sq_base + params.sq_off.array);
+  cq_head_ = reinterpret_cast<unsigned*>(cq_base + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned*>(cq_base + params.cq_off.tail);
+  cq_mask_ = *reinterpret_cast<unsigned*>(cq_base + params.cq_off.ring_mask);
+  cqes_ = cq_base + params.cq_off.cqes;
+
+  // Linked requests on a direct descriptor opened earlier in the same chain
+  // need the file to be looked up when the request runs, not when it is
+  // submitted (5.18). Older kernels also ignore sqe->file_index and would
+  // install the fdinfo files in the process table.
+  if ((params.features & IORING_FEAT_LINKED_FILE) == 0) {
+    return false;
+  }
+
+  // Every opcode used here must be supported (and not filtered by a
+  // restriction), otherwise the first batch would fail halfway.
+  const unsigned probe_ops = 256;
+  std::vector<char> probe_buf(sizeof(struct io_uring_probe) + probe_ops * sizeof(struct io_uring_probe_op), 0);
+  struct io_uring_probe* probe = reinterpret_cast<struct io_uring_probe*>(probe_buf.data());
+  if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, probe_ops) < 0) {
+    return false;
+  }
+  for (int op : {IORING_OP_STATX, IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE}) {
+    if (op > probe->last_op || (probe->ops[op].flags & IO_URING_OP_SUPPORTED) == 0) {
+      return false;
+    }
+  }
+
+  batch_size_ = std::min(sq_entries_, cq_entries_) / kSqesPerFd;
+  // The kernel caps the registered file table at RLIMIT_NOFILE.
+  struct rlimit lim;
+  if (getrlimit(RLIMIT_NOFILE, &lim) == 0 && lim.rlim_cur != RLIM_INFINITY) {
+    batch_size_ = std::min(batch_size_, static_cast<size_t>(lim.rlim_cur));
+  }
+  if (batch_size_ == 0) {
+    return false;
+  }
+
+  // One sparse direct-descriptor slot per batch entry; the fdinfo files are
+  // opened into these and never take a number in the process fd table.
+  std::vector<int> files(batch_size_, -1);
+  if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_FILES, files.data(),
+              static_cast<unsigned>(files.size())) < 0) {
+    return false;
+  }
+
+  slots_.reset(new Slot[batch_size_]);
+  return true;
+#else
+  (void)entries;
+  return false;
+#endif
+}
+
+struct io_uring_sqe* FdUringProber::NextSqe() {
+  unsigned tail = *sq_tail_;
+  unsigned index = tail & sq_mask_;
+  struct io_uring_sqe* sqe = static_cast<struct io_uring_sqe*>(sqes_) + index;
+  std::memset(sqe, 0, sizeof(*sqe));
+  sq_array_[index] = index;
+  // The kernel only reads the ring during io_uring_enter(), so the entry can
+  // be published before it is filled in.
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  return sqe;
+}
+
+bool FdUringProber::SubmitAndWait(unsigned count) {
+#ifdef __NR_io_uring_enter
+  unsigned to_submit = count;
+  unsigned completed = 0;
+  while (completed < count) {
+    unsigned wait = to_submit > 0 ? 0 : 1;
+    long ret = syscall(__NR_io_uring_enter, ring_fd_, to_submit, wait, IORING_ENTER_GETEVENTS, nullptr, 0);
+    if (ret < 0) {
+      if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+        failed_ = true;
+        return false;
+      }
+      // Reap what is there (EBUSY means the CQ is full) and try again.
+      ret = 0;
+    }
+    to_submit -= std::min(to_submit, static_cast<unsigned>(ret));
+
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++) {
+      const struct io_uring_cqe* cqe = static_cast<const struct io_uring_cqe*>(cqes_) + (head & cq_mask_);
+      size_t slot = static_cast<size_t>(cqe->user_data >> 2);
+      if (slot < batch_size_) {
+        Slot& s = slots_[slot];
+        switch (static_cast<SlotOp>(cqe->user_data & 3)) {
+          case kStat:
+            s.stat_res = cqe->res;
+            break;
+          case kOpen:
+            s.open_res = cqe->res;
+            break;
+          case kRead:
+            s.read_res = cqe->res;
+            break;
+          case kClose:
+            s.close_res = cqe->res;
+            break;
+        }
+      }
+      completed++;
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+  }
+  return true;
+#else
+  (void)count;
+  return false;
+#endif
+}
+
+bool FdUringProber::Probe(const int* fds, size_t n, FdUringResult* results) {
+  n = std::min(n, batch_size_);
+  pid_t pid = getpid();
+
+  for (size_t i = 0; i < n; i++) {
+    Slot& s = slots_[i];
+    s.stat_res = s.open_res = s.read_res = s.close_res = kPending;
+    std::snprintf(s.info_path, sizeof(s.info_path), "/proc/%d/fdinfo/%d", pid, fds[i]);
+
+    struct io_uring_sqe* sqe = NextSqe();
+    sqe->opcode = IORING_OP_STATX;
+    // Same as following /proc/<pid>/fd/N, without the procfs lookup.
+    sqe->fd = fds[i];
+    sqe->addr = reinterpret_cast<uintptr_t>("");
+    sqe->statx_flags = AT_EMPTY_PATH;
+    sqe->len = STATX_BASIC_STATS;
+    sqe->off = reinterpret_cast<uintptr_t>(&s.stx);
+    sqe->user_data = UserData(i, kStat);
+
+    // openat into direct slot i, then read and close it. A failed open
+    // cancels the rest of the chain; the hard link makes the close run even
+    // if the read fails.
+    sqe = NextSqe();
+    sqe->opcode = IORING_OP_OPENAT;
+    sqe->fd = AT_FDCWD;
+    sqe->addr = reinterpret_cast<uintptr_t>(s.info_path);
+    sqe->open_flags = O_RDONLY | O_CLOEXEC;
+    sqe->file_index = static_cast<uint32_t>(i + 1);
+    sqe->flags = IOSQE_IO_LINK;
+    sqe->user_data = UserData(i, kOpen);
+
+    sqe = NextSqe();
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = static_cast<int>(i);
+    sqe->addr = reinterpret_cast<uintptr_t>(s.info);
+    sqe->len = sizeof(s.info) - 1;
+    sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+    sqe->user_data = UserData(i, kRead);
+
+    sqe = NextSqe();
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->file_index = static_cast<uint32_t>(i + 1);
+    sqe->user_data = UserData(i, kClose);
+  }
+  // Direct descriptors live in the ring's file table, so a failed ring
+  // leaves nothing behind in the process fd table; destroying the ring
+  // releases any slot that is still open.
+  bool ok = SubmitAndWait(static_cast<unsigned>(n * kSqesPerFd));
+
+  for (size_t i = 0; i < n; i++) {
+    Slot& s = slots_[i];
+    FdUringResult& r = results[i];
+    r = FdUringResult();
+    if (!ok) {
+      continue;
+    }
+    if (s.stat_res == 0) {
+      StatFromStatx(s.stx, &r.st);
+      r.stat_ok = true;
+    }
+    if (s.read_res > 0) {
+      s.info[s.read_res] = '\0';
+      r.flags_ok = ParseFdinfoFlags(s.info, &r.open_flags, &r.fd_flags);
+    }
+  }
+  return ok;
+}
@@ -0,0 +1,115 @@
+#ifndef FLUTTER_FD_UTILS_FD_URING_PROBE_H_
+#define FLUTTER_FD_UTILS_FD_URING_PROBE_H_
+
+#include <cstddef>
+#include <memory>
+#include <sys/stat.h>
+
+struct io_uring_sqe;
+
+// Batched replacement for the per-descriptor fstat() and fcntl() calls of a
+// collection pass, built on io_uring.
+//
+// For a batch of descriptors, one submission carries an IORING_OP_STATX of
+// each descriptor (AT_EMPTY_PATH, which stats the same object as
+// /proc/<pid>/fd/N) and a linked OPENAT, READ and CLOSE of
+// /proc/<pid>/fdinfo/N. The fdinfo files are opened as io_uring direct
+// descriptors, so probing never takes numbers from the process fd table,
+// which matters most when it is close to RLIMIT_NOFILE. The "flags:" line
+// of fdinfo is F_GETFL with O_CLOEXEC standing in for F_GETFD. readlink() and
+// the socket probes have no io_uring equivalent and stay on the caller's
+// thread.
+//
+// The kernel runs statx and procfs reads on its io-wq workers, so whether this
+// beats the syscall loop depends on the kernel and the number of CPUs;
+// benchmark/collect_benchmark.cc compares the two.
+//
+// Setting up a ring (the ring mappings, the opcode probe and the registered
+// file table) costs far more than probing a typical table, so one prober is
+// kept for the process and lent to a collection pass at a time; a pass that
+// runs while it is lent out gets a temporary one.
+//
+// Only raw syscalls are used, so there is no liburing dependency. Kernels
+// before 5.18 (IORING_FEAT_LINKED_FILE) or without the needed opcodes,
+// io_uring_disabled, and seccomp filters all make Acquire() return nullptr;
+// callers then use syscalls.
+
+struct FdUringResult {
+  // False if the statx failed; the caller probes the descriptor itself
+  // (which also decides whether it is gone).
+  bool stat_ok = false;
+  struct stat st;
+  // False if fdinfo could not be opened or read (e.g. EMFILE).
+  bool flags_ok = false;
+  int open_flags = -1;
+  int fd_flags = -1;
+};
+
+class FdUringProber {
+ public:
+  // Hands the prober back to the process-wide slot, or destroys it if the
+  // slot is taken or the ring failed.
+  struct Releaser {
+    void operator()(FdUringProber* prober) const;
+  };
+  typedef std::unique_ptr<FdUringProber, Releaser> Lease;
+
+  // Lends out the shared prober, or sets up a new one if it is in use.
+  // Returns nullptr if io_uring cannot be used in this process. A failed
+  // setup is remembered, so later calls return quickly.
+  static Lease Acquire();
+
+  // Whether Acquire() can succeed.
+  static bool Available();
+
+  ~FdUringProber();
+
+  // Maximum number of descriptors per Probe() call.
+  size_t batch_size() const { return batch_size_; }
+
+  // The ring's own descriptor, which collection passes leave out.
+  int ring_fd() const { return ring_fd_; }
+
+  // Fills |results|[i] for |fds|[i], i < |n| <= batch_size(). Returns false
+  // if the ring itself failed; the prober should not be used again.
+  bool Probe(const int* fds, size_t n, FdUringResult* results);
+
+ private:
+  struct Slot;
+
+  FdUringProber() = default;
+
+  static std::unique_ptr<FdUringProber> Create();
+
+  bool Setup(unsigned entries);
+  // Returns the next free SQE, zeroed; at most sq_entries_ per round.
+  struct io_uring_sqe* NextSqe();
+  // Submits the SQEs queued since the last call, waits for as many
+  // completions and stores each result in the slot named by its user_data.
+  bool SubmitAndWait(unsigned count);
+
+  int ring_fd_ = -1;
+  size_t batch_size_ = 0;
+  unsigned sq_entries_ = 0;
+  unsigned cq_entries_ = 0;
+  void* sq_ring_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  void* cq_ring_ = nullptr;
+  size_t cq_ring_size_ = 0;
+  void* sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+
+  unsigned* sq_tail_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned* sq_array_ = nullptr;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  void* cqes_ = nullptr;
+
+  std::unique_ptr<Slot[]> slots_;
+  // Set when SubmitAndWait() gave up with requests possibly still in flight.
+  bool failed_ = false;
+};
+
+#endif  // FLUTTER_FD_UTILS_FD_URING_PROBE_H_
@@ -0,0 +1,88 @@
+#include "include/flutter_fd_utils/flutter_fd_utils_ffi.h"
+
+#include "fd_collector.h"
+#include "fd_snapshot_cache.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <sys/resource.h>
+
+// Collecting can throw (std::bad_alloc, or a failure rethrown by the cache to
+// every waiter); the entry points below turn that into -1 so nothing unwinds
+// across the C ABI.
+static std::shared_ptr<const FdSnapshot> GetSnapshot(int64_t max_age_ms) {
+  if (max_age_ms < 0) {
+    return FdSnapshotCache::Instance().Get();
+  }
+  return FdSnapshotCache::Instance().Get(std::chrono::milliseconds(max_age_ms));
+}
+
+int32_t flutter_fd_utils_ffi_abi_version(void) {
+  return FLUTTER_FD_UTILS_FFI_ABI_VERSION;
+}
+
+int64_t flutter_fd_utils_get_fd_count(void) {
+  return CountFds();
+}
+
+int32_t flutter_fd_utils_get_nofile_limit(int64_t* soft, int64_t* hard) {
+  struct rlimit lim;
+  if (getrlimit(RLIMIT_NOFILE, &lim) != 0) {
+    return errno;
+  }
+  if (soft != nullptr) *soft = static_cast<int64_t>(lim.rlim_cur);
+  if (hard != nullptr) *hard = static_cast<int64_t>(lim.rlim_max);
+  return 0;
+}
+
+int32_t flutter_fd_utils_get_fd_summary(int64_t max_age_ms, FlutterFdUtilsSummary* out) {
+  if (out == nullptr) {
+    return EINVAL;
+  }
+  std::memset(out, 0, sizeof(*out));
+
+  try {
+    auto snapshot = GetSnapshot(max_age_ms);
+    FdTypeCounts counts = CountFdTypes(snapshot->entries);
+    out->fd_count = static_cast<int64_t>(snapshot->entries.size());
+    out->vnode_count = counts.vnode;
+    out->socket_count = counts.socket;
+    out->pipe_count = counts.pipe;
+    out->unknown_count = counts.unknown;
+    out->non_cloexec_count = counts.non_cloexec;
+    out->snapshot_age_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                               std::chrono::steady_clock::now() - snapshot->captured_at)
+                               .count();
+  } catch (...) {
+    return -1;
+  }
+  return flutter_fd_utils_get_nofile_limit(&out->nofile_soft, &out->nofile_hard);
+}
+
+int64_t flutter_fd_utils_get_fd_snapshot(int64_t max_age_ms,
+                                         int32_t* fds,
+                                         int32_t* fd_types,
+                                         int32_t* open_flags,
+                                         int32_t* fd_flags,
+                                         int64_t capacity) {
+  std::shared_ptr<const FdSnapshot> snapshot;
+  try {
+    snapshot = GetSnapshot(max_age_ms);
+  } catch (...) {
+    return -1;
+  }
+  const auto& entries = snapshot->entries;
+  int64_t rows = static_cast<int64_t>(entries.size());
+  if (capacity < rows) {
+    rows = capacity < 0 ? 0 : capacity;
+  }
+  for (int64_t i = 0; i < rows; i++) {
+    const FdEntry& e = entries[static_cast<size_t>(i)];
+    if (fds != nullptr) fds[i] = e.fd;
+    if (fd_types != nullptr) fd_types[i] = e.fd_type;
+    if (open_flags != nullptr) open_flags[i] = e.open_flags;
+    if (fd_flags != nullptr) fd_flags[i] = e.fd_flags;
+  }
+  return static_cast<int64_t>(entries.size());
+}
@@ -1,564 +1,555 @@
 #include "include/flutter_fd_utils/flutter_fd_utils_plugin.h"
 
+#include "fd_collector.h"
+#include "fd_collector_stats.h"
+#include "fd_emergency_dump.h"
+#include "fd_entry_schema.h"
+#include "fd_file_usage.h"
+#include "fd_pressure.h"
+#include "fd_report_stream.h"
+#include "fd_shm_publisher.h"
+#include "fd_snapshot_cache.h"
+#include "fd_table_ops.h"
+#include "fd_trace_exporter.h"
+#include "fd_unix_peers.h"
+#include "fd_uring_probe.h"
+
 #include <flutter_linux/flutter_linux.h>
 #include <gtk/gtk.h>
 
-#include <chrono>
-#include <arpa/inet.h>
-#include <cstdlib>
 #include <cerrno>
-#include <cstdio>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
 #include <cstring>
-#include <dirent.h>
 #include <fcntl.h>
-#include <iomanip>
-#include <linux/tcp.h>
-#include <limits.h>
 #include <map>
-#include <netinet/in.h>
-#include <sys/un.h>
-#include <sstream>
+#include <mutex>
+#include <signal.h>
 #include <string>
 #include <sys/resource.h>
-#include <sys/socket.h>
-#include <sys/stat.h>
-#include <ctime>
-#include <unistd.h>
 #include <vector>
 
-#define FD_TYPE_UNKNOWN 0
-#define FD_TYPE_VNODE 1
-#define FD_TYPE_SOCKET 2
-#define FD_TYPE_PIPE 6
-
-struct SocketDetails {
-  bool present = false;
-  bool has_so_type = false;
-  int so_type = 0;
-  bool has_so_proto = false;
-  int so_proto = 0;
-  bool has_family = false;
-  int family = 0;
-  std::string local;
-  std::string peer;
-  bool has_tcp_state = false;
-  int tcp_state = 0;
-  std::string tcp_state_name;
-};
+// Renders the fields of fd_entry_schema.h into an FlValue map, with socket
+// and vnode fields in nested maps that are created by their first field.
+class FdListEncoder {
+ public:
+  FdListEncoder() : map_(fl_value_new_map()) {}
 
-struct VnodeDetails {
-  bool present = false;
-  int mode = 0;
-  long long size = 0;
-};
+  FlValue* map() const { return map_; }
 
-struct FdEntry {
-  int fd = -1;
-  int fd_type = FD_TYPE_UNKNOWN;
-  std::string fd_type_name;
-  int open_flags = -1;
-  int fd_flags = -1;
-  std::string path;
-  SocketDetails socket;
-  VnodeDetails vnode;
-};
+  void Int(const FdField& f, long long value, bool in_list, bool) {
+    if (!in_list || f.list_key == nullptr) return;
+    bool null = (f.flags & FD_FIELD_NULLABLE) != 0 && value < 0;
+    Set(f, f.list_key, null ? fl_value_new_null() : fl_value_new_int(value));
+  }
 
-static std::string Iso8601Now() {
-  auto now = std::chrono::system_clock::now();
-  std::time_t tt = std::chrono::system_clock::to_time_t(now);
-  std::tm tm_utc{};
-  gmtime_r(&tt, &tm_utc);
+  void Bool(const FdField& f, bool value, bool in_list, bool) {
+    if (!in_list || f.list_key == nullptr) return;
+    Set(f, f.list_key, fl_value_new_bool(value));
+  }
 
-  std::ostringstream ss;
-  ss << std::put_time(&tm_utc, "%Y-%m-%dT%H:%M:%S");
+  void String(const FdField& f, const std::string& value, bool in_list, bool) {
+    if (!in_list || f.list_key == nullptr) return;
+    bool null = (f.flags & FD_FIELD_NULLABLE) != 0 && value.empty();
+    Set(f, f.list_key, null ? fl_value_new_null() : fl_value_new_string(value.c_str()));
+  }
 
-  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
-  ss << "." << std::setfill('0') << std::setw(3) << ms.count() << "Z";
-  return ss.str();
-}
+  void Named(const FdField& f, long long value, const std::string& name, bool in_list, bool) {
+    if (!in_list || f.list_key == nullptr) return;
+    Set(f, f.list_key, fl_value_new_int(value));
+    if (f.list_name_key != nullptr) {
+      Set(f, f.list_name_key, fl_value_new_string(name.c_str()));
+    }
+  }
 
-static std::string DescribeSockaddr(const struct sockaddr* addr, socklen_t len) {
-  if (addr == nullptr || len == 0) {
-    return "";
+ private:
+  void Set(const FdField& f, const char* key, FlValue* value) {
+    fl_value_set_string_take(Target(f.group), key, value);
   }
 
-  if (addr->sa_family == AF_INET) {
-    const struct sockaddr_in* in4 = reinterpret_cast<const struct sockaddr_in*>(addr);
-    char ip[INET_ADDRSTRLEN];
-    const char* p = inet_ntop(AF_INET, &in4->sin_addr, ip, sizeof(ip));
-    int port = ntohs(in4->sin_port);
-    if (p != nullptr) {
-      std::ostringstream ss;
-      ss << p << ":" << port;
-      return ss.str();
-    }
-    return "AF_INET:" + std::to_string(port);
-  }
-
-  if (addr->sa_family == AF_INET6) {
-    const struct sockaddr_in6* in6 = reinterpret_cast<const struct sockaddr_in6*>(addr);
-    char ip[INET6_ADDRSTRLEN];
-    const char* p = inet_ntop(AF_INET6, &in6->sin6_addr, ip, sizeof(ip));
-    int port = ntohs(in6->sin6_port);
-    if (p != nullptr) {
-      std::ostringstream ss;
-      ss << "[" << p << "]:" << port;
-      return ss.str();
+  FlValue* Target(FdFieldGroup group) {
+    switch (group) {
+      case FD_GROUP_SOCKET:
+        return Nested(&socket_, "socket");
+      case FD_GROUP_VNODE:
+        return Nested(&vnode_, "vnode");
+      default:
+        return map_;
     }
-    return "AF_INET6:" + std::to_string(port);
   }
 
-  if (addr->sa_family == AF_UNIX) {
-    const struct sockaddr_un* un = reinterpret_cast<const struct sockaddr_un*>(addr);
-    if (un->sun_path[0] != 0) {
-      return std::string("unix:") + un->sun_path;
+  FlValue* Nested(FlValue** slot, const char* key) {
+    if (*slot == nullptr) {
+      *slot = fl_value_new_map();
+      fl_value_set_string_take(map_, key, *slot);
     }
-    return "unix:(anonymous)";
-  }
-
-  return std::string("family=") + std::to_string(addr->sa_family);
-}
-
-static std::string TcpStateName(int state) {
-#ifndef TCP_ESTABLISHED
-#define TCP_ESTABLISHED 1
-#define TCP_SYN_SENT 2
-#define TCP_SYN_RECV 3
-#define TCP_FIN_WAIT1 4
-#define TCP_FIN_WAIT2 5
-#define TCP_TIME_WAIT 6
-#define TCP_CLOSE 7
-#define TCP_CLOSE_WAIT 8
-#define TCP_LAST_ACK 9
-#define TCP_LISTEN 10
-#define TCP_CLOSING 11
-#endif
-  switch (state) {
-    case TCP_ESTABLISHED:
-      return "ESTABLISHED";
-    case TCP_SYN_SENT:
-      return "SYN_SENT";
-    case TCP_SYN_RECV:
-      return "SYN_RECV";
-    case TCP_FIN_WAIT1:
-      return "FIN_WAIT_1";
-    case TCP_FIN_WAIT2:
-      return "FIN_WAIT_2";
-    case TCP_TIME_WAIT:
-      return "TIME_WAIT";
-    case TCP_CLOSE:
-      return "CLOSED";
-    case TCP_CLOSE_WAIT:
-      return "CLOSE_WAIT";
-    case TCP_LAST_ACK:
-      return "LAST_ACK";
-    case TCP_LISTEN:
-      return "LISTEN";
-    case TCP_CLOSING:
-      return "CLOSING";
-    default:
-      return "UNKNOWN(" + std::to_string(state) + ")";
+    return *slot;
   }
-}
 
-static std::string OpenFlagsString(int fd) {
-  int fl = fcntl(fd, F_GETFL);
-  if (fl < 0) {
-    return "";
-  }
+  FlValue* map_;
+  FlValue* socket_ = nullptr;
+  FlValue* vnode_ = nullptr;
+};
 
-  std::vector<std::string> parts;
-  int acc = fl & O_ACCMODE;
-  if (acc == O_RDONLY) {
-    parts.emplace_back("RDONLY");
-  } else if (acc == O_WRONLY) {
-    parts.emplace_back("WRONLY");
-  } else if (acc == O_RDWR) {
-    parts.emplace_back("RDWR");
-  }
-  if ((fl & O_NONBLOCK) != 0) {
-    parts.emplace_back("NONBLOCK");
-  }
-  if ((fl & O_APPEND) != 0) {
-    parts.emplace_back("APPEND");
-  }
-  if ((fl & O_SYNC) != 0) {
-    parts.emplace_back("SYNC");
+// Adds the encoding time to |timings| when given; it is always recorded in
+// FdCollectorStats.
+static FlValue* BuildFdListValue(const std::vector<FdEntry>& list, FdPhaseTimings* timings = nullptr) {
+  long long encode_start = MonotonicNowNs();
+  FlValue* arr = fl_value_new_list();
+  for (const auto& e : list) {
+    FdListEncoder encoder;
+    VisitFdEntry(e, &encoder);
+    fl_value_append_take(arr, encoder.map());
   }
 
-  std::ostringstream ss;
-  for (size_t i = 0; i < parts.size(); i++) {
-    if (i > 0) ss << "|";
-    ss << parts[i];
+  long long encode_ns = MonotonicNowNs() - encode_start;
+  FdCollectorStats::Instance().RecordPhase(FD_PHASE_ENCODE, encode_ns);
+  if (timings != nullptr) {
+    timings->ns[FD_PHASE_ENCODE] += encode_ns;
   }
-  return ss.str();
+  return arr;
 }
 
-static std::string FdFlagsString(int fd) {
-  int flags = fcntl(fd, F_GETFD);
-  if (flags < 0) {
-    return "";
-  }
-  if ((flags & FD_CLOEXEC) != 0) {
-    return "CLOEXEC";
+// Phase name -> nanoseconds for every phase that ran.
+static FlValue* BuildTimingsMap(const FdPhaseTimings& timings) {
+  FlValue* map = fl_value_new_map();
+  for (int phase = 0; phase < FD_PHASE_COUNT; phase++) {
+    if (timings.ns[phase] > 0) {
+      fl_value_set_string_take(map, FdPhaseName(phase), fl_value_new_int(timings.ns[phase]));
+    }
   }
-  return "";
+  return map;
 }
 
-static std::string ReadFdPath(int fd) {
-  char linkname[PATH_MAX];
-  std::snprintf(linkname, sizeof(linkname), "/proc/self/fd/%d", fd);
-
-  char buf[PATH_MAX];
-  ssize_t len = readlink(linkname, buf, sizeof(buf) - 1);
-  if (len <= 0) {
-    return "";
+static FlValue* BuildHistogramMap(const LatencyHistogram& h) {
+  FlValue* map = fl_value_new_map();
+  fl_value_set_string_take(map, "count", fl_value_new_int(h.count()));
+  fl_value_set_string_take(map, "minNs", fl_value_new_int(h.min()));
+  fl_value_set_string_take(map, "maxNs", fl_value_new_int(h.max()));
+  fl_value_set_string_take(map, "meanNs", fl_value_new_int(h.count() > 0 ? h.sum() / h.count() : 0));
+  fl_value_set_string_take(map, "p50Ns", fl_value_new_int(h.ValueAtPercentile(50)));
+  fl_value_set_string_take(map, "p90Ns", fl_value_new_int(h.ValueAtPercentile(90)));
+  fl_value_set_string_take(map, "p99Ns", fl_value_new_int(h.ValueAtPercentile(99)));
+  fl_value_set_string_take(map, "p999Ns", fl_value_new_int(h.ValueAtPercentile(99.9)));
+  FlValue* buckets = fl_value_new_list();
+  for (const auto& bucket : h.Buckets()) {
+    FlValue* pair = fl_value_new_list();
+    fl_value_append_take(pair, fl_value_new_int(bucket.first));
+    fl_value_append_take(pair, fl_value_new_int(bucket.second));
+    fl_value_append_take(buckets, pair);
   }
-  buf[len] = '\0';
-  return std::string(buf);
+  fl_value_set_string_take(map, "buckets", buckets);
+  return map;
 }
 
-static const char* FdTypeName(int type) {
-  switch (type) {
-    case FD_TYPE_VNODE:
-      return "VNODE";
-    case FD_TYPE_SOCKET:
-      return "SOCKET";
-    case FD_TYPE_PIPE:
-      return "PIPE";
-    default:
-      return "UNKNOWN";
-  }
-}
+struct _FlutterFdUtilsPlugin {
+  GObject parent_instance;
+  FlEventChannel* report_stream_channel;
+};
 
-static SocketDetails BuildSocketDetails(int fd) {
-  SocketDetails s;
+G_DEFINE_TYPE(FlutterFdUtilsPlugin, flutter_fd_utils_plugin, g_object_get_type())
 
-  int so_type = 0;
-  socklen_t so_type_len = sizeof(so_type);
-  if (getsockopt(fd, SOL_SOCKET, SO_TYPE, &so_type, &so_type_len) == 0) {
-    s.has_so_type = true;
-    s.so_type = so_type;
-    s.present = true;
+// Reads an optional numeric argument; the Dart side may send ints or doubles.
+static bool LookupNumberArg(FlValue* args, const char* key, gint64* out) {
+  if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
+    return false;
   }
-
-  int so_proto = 0;
-  socklen_t so_proto_len = sizeof(so_proto);
-#ifdef SO_PROTOCOL
-  if (getsockopt(fd, SOL_SOCKET, SO_PROTOCOL, &so_proto, &so_proto_len) == 0) {
-    s.has_so_proto = true;
-    s.so_proto = so_proto;
-    s.present = true;
+  FlValue* value = fl_value_lookup_string(args, key);
+  if (value == nullptr) {
+    return false;
   }
-#endif
-
-  struct sockaddr_storage laddr;
-  socklen_t laddr_len = sizeof(laddr);
-  if (getsockname(fd, reinterpret_cast<struct sockaddr*>(&laddr), &laddr_len) == 0) {
-    s.local = DescribeSockaddr(reinterpret_cast<struct sockaddr*>(&laddr), laddr_len);
-    s.family = reinterpret_cast<struct sockaddr*>(&laddr)->sa_family;
-    s.has_family = true;
-    s.present = true;
+  if (fl_value_get_type(value) == FL_VALUE_TYPE_INT) {
+    *out = fl_value_get_int(value);
+    return true;
   }
-
-  struct sockaddr_storage raddr;
-  socklen_t raddr_len = sizeof(raddr);
-  if (getpeername(fd, reinterpret_cast<struct sockaddr*>(&raddr), &raddr_len) == 0) {
-    s.peer = DescribeSockaddr(reinterpret_cast<struct sockaddr*>(&raddr), raddr_len);
-    if (!s.has_family) {
-      s.family = reinterpret_cast<struct sockaddr*>(&raddr)->sa_family;
-      s.has_family = true;
-    }
-    s.present = true;
+  if (fl_value_get_type(value) == FL_VALUE_TYPE_FLOAT) {
+    *out = static_cast<gint64>(fl_value_get_float(value));
+    return true;
   }
+  return false;
+}
 
-#ifdef TCP_INFO
-  struct tcp_info tcpi;
-  socklen_t tcpi_len = sizeof(tcpi);
-  if (getsockopt(fd, IPPROTO_TCP, TCP_INFO, &tcpi, &tcpi_len) == 0) {
-    s.has_tcp_state = true;
-    s.tcp_state = tcpi.tcpi_state;
-    s.tcp_state_name = TcpStateName(tcpi.tcpi_state);
-    s.present = true;
+static std::shared_ptr<const FdSnapshot> GetSnapshot(FlMethodCall* method_call) {
+  gint64 max_age_ms = 0;
+  if (LookupNumberArg(fl_method_call_get_args(method_call), "maxAgeMs", &max_age_ms)) {
+    return FdSnapshotCache::Instance().Get(std::chrono::milliseconds(max_age_ms));
   }
-#endif
+  return FdSnapshotCache::Instance().Get();
+}
 
-  return s;
+// Whether the call carries a budget and so runs its own collection.
+static bool HasBudgetArgs(FlValue* args) {
+  gint64 value = 0;
+  return LookupNumberArg(args, "startFd", &value) || LookupNumberArg(args, "timeBudgetMs", &value) ||
+         LookupNumberArg(args, "maxProbes", &value);
 }
 
-static VnodeDetails BuildVnodeDetails(const struct stat& st) {
-  VnodeDetails v;
-  v.present = true;
-  v.mode = static_cast<int>(st.st_mode);
-  v.size = static_cast<long long>(st.st_size);
-  return v;
+// Cancellation flags of budgeted collections, keyed by the Dart-side
+// requestId. Entries are added on the main thread when the call is dispatched,
+// so a later cancelFdCollection message always finds them. Unbudgeted calls
+// are served from the snapshot cache and are not registered, so cancelling
+// them reports false.
+static std::mutex& CollectionsMutex() {
+  static std::mutex* mutex = new std::mutex();
+  return *mutex;
 }
 
-static std::vector<FdEntry> CollectFdList() {
-  std::vector<FdEntry> out;
+static std::map<gint64, std::shared_ptr<std::atomic<bool>>>& Collections() {
+  static auto* collections = new std::map<gint64, std::shared_ptr<std::atomic<bool>>>();
+  return *collections;
+}
 
-  DIR* dir = opendir("/proc/self/fd");
-  if (dir == nullptr) {
-    return out;
+static void RegisterCollection(FlMethodCall* method_call) {
+  FlValue* args = fl_method_call_get_args(method_call);
+  gint64 request_id = 0;
+  if (HasBudgetArgs(args) && LookupNumberArg(args, "requestId", &request_id)) {
+    std::lock_guard<std::mutex> lock(CollectionsMutex());
+    Collections()[request_id] = std::make_shared<std::atomic<bool>>(false);
   }
+}
 
-  struct dirent* ent;
-  while ((ent = readdir(dir)) != nullptr) {
-    if (ent->d_name[0] == '.') {
-      continue;
-    }
-
-    int fd = std::atoi(ent->d_name);
-    if (fd < 0) {
-      continue;
-    }
-
-    struct stat st;
-    if (fstat(fd, &st) != 0) {
-      continue;
-    }
-
-    FdEntry e;
-    e.fd = fd;
-    e.open_flags = fcntl(fd, F_GETFL);
-    e.fd_flags = fcntl(fd, F_GETFD);
-    e.path = ReadFdPath(fd);
-
-    if (S_ISSOCK(st.st_mode)) {
-      e.fd_type = FD_TYPE_SOCKET;
-      e.fd_type_name = FdTypeName(e.fd_type);
-      e.socket = BuildSocketDetails(fd);
-    } else if (S_ISFIFO(st.st_mode)) {
-      e.fd_type = FD_TYPE_PIPE;
-      e.fd_type_name = FdTypeName(e.fd_type);
-    } else {
-      e.fd_type = FD_TYPE_VNODE;
-      e.fd_type_name = FdTypeName(e.fd_type);
-      e.vnode = BuildVnodeDetails(st);
-    }
-
-    out.push_back(std::move(e));
-  }
+static std::shared_ptr<std::atomic<bool>> FindCollection(gint64 request_id) {
+  std::lock_guard<std::mutex> lock(CollectionsMutex());
+  auto it = Collections().find(request_id);
+  return it == Collections().end() ? nullptr : it->second;
+}
 
-  closedir(dir);
-  return out;
+static void UnregisterCollection(gint64 request_id) {
+  std::lock_guard<std::mutex> lock(CollectionsMutex());
+  Collections().erase(request_id);
 }
 
-static FlValue* BuildSocketMap(const SocketDetails& s) {
-  if (!s.present) {
-    return nullptr;
-  }
+// Runs a collection honouring the optional startFd / timeBudgetMs / maxProbes /
+// requestId arguments. Returns false (leaving |result| untouched) when no
+// budget was given, in which case the caller should use the snapshot cache; a
+// requestId alone is ignored, since a shared collection cannot be cancelled.
+static bool CollectWithBudget(FlMethodCall* method_call, FdCollectResult* result) {
+  FlValue* args = fl_method_call_get_args(method_call);
+  FdCollectOptions options;
+  bool budgeted = false;
 
-  FlValue* map = fl_value_new_map();
-  if (s.has_so_type) {
-    fl_value_set_string_take(map, "soType", fl_value_new_int(s.so_type));
-  }
-  if (s.has_so_proto) {
-    fl_value_set_string_take(map, "soProto", fl_value_new_int(s.so_proto));
+  gint64 value = 0;
+  if (LookupNumberArg(args, "startFd", &value)) {
+    options.start_fd = static_cast<int>(value);
+    budgeted = true;
   }
-  if (s.has_family) {
-    fl_value_set_string_take(map, "family", fl_value_new_int(s.family));
+  if (LookupNumberArg(args, "timeBudgetMs", &value)) {
+    options.has_deadline = true;
+    options.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(value);
+    budgeted = true;
   }
-  if (!s.local.empty()) {
-    fl_value_set_string_take(map, "local", fl_value_new_string(s.local.c_str()));
-  } else {
-    fl_value_set_string_take(map, "local", fl_value_new_null());
+  if (LookupNumberArg(args, "maxProbes", &value)) {
+    options.max_probes = static_cast<long>(value);
+    budgeted = true;
   }
-  if (!s.peer.empty()) {
-    fl_value_set_string_take(map, "peer", fl_value_new_string(s.peer.c_str()));
-  } else {
-    fl_value_set_string_take(map, "peer", fl_value_new_null());
+  if (!budgeted) {
+    return false;
   }
-  if (s.has_tcp_state) {
-    fl_value_set_string_take(map, "tcpState", fl_value_new_int(s.tcp_state));
-    fl_value_set_string_take(map, "tcpStateName", fl_value_new_string(s.tcp_state_name.c_str()));
+  gint64 request_id = 0;
+  bool has_request_id = LookupNumberArg(args, "requestId", &request_id);
+  std::shared_ptr<std::atomic<bool>> cancelled;
+  if (has_request_id) {
+    cancelled = FindCollection(request_id);
+    options.cancelled = cancelled.get();
   }
-  return map;
-}
 
-static FlValue* BuildVnodeMap(const VnodeDetails& v) {
-  if (!v.present) {
-    return nullptr;
+  *result = CollectFdList(options);
+  if (has_request_id) {
+    UnregisterCollection(request_id);
   }
-  FlValue* map = fl_value_new_map();
-  fl_value_set_string_take(map, "mode", fl_value_new_int(v.mode));
-  fl_value_set_string_take(map, "size", fl_value_new_int(v.size));
-  return map;
+  if (!result->truncated && options.start_fd == 0) {
+    FdSnapshotCache::Instance().Store(result->entries, result->timings);
+  }
+  return true;
 }
 
-static FlValue* BuildFdListValue(const std::vector<FdEntry>& list) {
-  FlValue* arr = fl_value_new_list();
-  for (const auto& e : list) {
-    FlValue* map = fl_value_new_map();
-    fl_value_set_string_take(map, "fd", fl_value_new_int(e.fd));
-    fl_value_set_string_take(map, "fdType", fl_value_new_int(e.fd_type));
-    fl_value_set_string_take(map, "fdTypeName", fl_value_new_string(e.fd_type_name.c_str()));
-
-    if (e.open_flags >= 0) {
-      fl_value_set_string_take(map, "openFlags", fl_value_new_int(e.open_flags));
-    } else {
-      fl_value_set_string_take(map, "openFlags", fl_value_new_null());
-    }
-
-    if (e.fd_flags >= 0) {
-      fl_value_set_string_take(map, "fdFlags", fl_value_new_int(e.fd_flags));
-    } else {
-      fl_value_set_string_take(map, "fdFlags", fl_value_new_null());
-    }
-
-    if (!e.path.empty()) {
-      fl_value_set_string_take(map, "path", fl_value_new_string(e.path.c_str()));
-    } else {
-      fl_value_set_string_take(map, "path", fl_value_new_null());
-    }
+static FlMethodResponse* CancelledResponse() {
+  return FL_METHOD_RESPONSE(fl_method_error_response_new("cancelled", "fd collection was cancelled", nullptr));
+}
 
-    if (auto socket_map = BuildSocketMap(e.socket)) {
-      fl_value_set_string_take(map, "socket", socket_map);
-    }
-    if (auto vnode_map = BuildVnodeMap(e.vnode)) {
-      fl_value_set_string_take(map, "vnode", vnode_map);
+static FlMethodResponse* HandleGetFdReport(FlMethodCall* method_call) {
+  std::string report;
+  FdCollectResult partial;
+  if (CollectWithBudget(method_call, &partial)) {
+    if (partial.cancelled) {
+      return CancelledResponse();
     }
-
-    fl_value_append_take(arr, map);
+    report = BuildFdReport(partial.entries, partial.truncated ? partial.next_fd : -1, &partial.timings);
+  } else {
+    auto snapshot = GetSnapshot(method_call);
+    FdPhaseTimings timings = snapshot->timings;
+    report = BuildFdReport(snapshot->entries, -1, &timings);
   }
-  return arr;
+  g_autoptr(FlValue) result = fl_value_new_string(report.c_str());
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
-static std::string BuildFdReport(const std::vector<FdEntry>& list) {
-  std::ostringstream out;
-  pid_t pid = getpid();
+static FlMethodResponse* HandleGetFdList(FlMethodCall* method_call) {
+  auto snapshot = GetSnapshot(method_call);
+  g_autoptr(FlValue) result = BuildFdListValue(snapshot->entries);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
 
+// Report, list and summary of one snapshot, so callers that show both views
+// pay for a single collection.
+static FlMethodResponse* HandleGetFdSnapshot(FlMethodCall* method_call) {
+  auto snapshot = GetSnapshot(method_call);
+  FdPhaseTimings timings = snapshot->timings;
+
+  g_autoptr(FlValue) result = fl_value_new_map();
+  fl_value_set_string_take(result, "entries", BuildFdListValue(snapshot->entries, &timings));
+  std::string report = BuildFdReport(snapshot->entries, -1, &timings);
+  fl_value_set_string_take(result, "report", fl_value_new_string(report.c_str()));
+
+  FdTypeCounts counts = CountFdTypes(snapshot->entries);
+  FlValue* summary = fl_value_new_map();
+  fl_value_set_string_take(summary, "fdCount", fl_value_new_int(static_cast<gint64>(snapshot->entries.size())));
+  fl_value_set_string_take(summary, "vnodeCount", fl_value_new_int(counts.vnode));
+  fl_value_set_string_take(summary, "socketCount", fl_value_new_int(counts.socket));
+  fl_value_set_string_take(summary, "pipeCount", fl_value_new_int(counts.pipe));
+  fl_value_set_string_take(summary, "unknownCount", fl_value_new_int(counts.unknown));
+  fl_value_set_string_take(summary, "nonCloexecCount", fl_value_new_int(counts.non_cloexec));
   struct rlimit lim;
-  int rlim_ret = getrlimit(RLIMIT_NOFILE, &lim);
+  if (getrlimit(RLIMIT_NOFILE, &lim) == 0) {
+    fl_value_set_string_take(summary, "nofileSoft", fl_value_new_int(static_cast<gint64>(lim.rlim_cur)));
+    fl_value_set_string_take(summary, "nofileHard", fl_value_new_int(static_cast<gint64>(lim.rlim_max)));
+  }
+  fl_value_set_string_take(summary, "snapshotAgeUs",
+                           fl_value_new_int(std::chrono::duration_cast<std::chrono::microseconds>(
+                                                std::chrono::steady_clock::now() - snapshot->captured_at)
+                                                .count()));
+  fl_value_set_string_take(result, "summary", summary);
+  fl_value_set_string_take(result, "timings", BuildTimingsMap(timings));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
 
-  out << "timestamp_utc: " << Iso8601Now() << "\n";
-  out << "pid: " << pid << "\n";
-  if (rlim_ret == 0) {
-    out << "rlimit_nofile_cur: " << static_cast<unsigned long long>(lim.rlim_cur) << "\n";
-    out << "rlimit_nofile_max: " << static_cast<unsigned long long>(lim.rlim_max) << "\n";
+static FlMethodResponse* HandleGetFdListPage(FlMethodCall* method_call) {
+  FdCollectResult page;
+  if (!CollectWithBudget(method_call, &page)) {
+    auto snapshot = GetSnapshot(method_call);
+    page.entries = snapshot->entries;
+    page.timings = snapshot->timings;
+  }
+  if (page.cancelled) {
+    return CancelledResponse();
+  }
+
+  g_autoptr(FlValue) result = fl_value_new_map();
+  fl_value_set_string_take(result, "entries", BuildFdListValue(page.entries, &page.timings));
+  fl_value_set_string_take(result, "timings", BuildTimingsMap(page.timings));
+  fl_value_set_string_take(result, "truncated", fl_value_new_bool(page.truncated));
+  if (page.truncated) {
+    fl_value_set_string_take(result, "nextFd", fl_value_new_int(page.next_fd));
   } else {
-    out << "getrlimit(RLIMIT_NOFILE) failed errno=" << errno << "\n";
+    fl_value_set_string_take(result, "nextFd", fl_value_new_null());
   }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
 
-  out << "fd_count: " << list.size() << "\n\n";
-  out << "fd_type_counts:\n";
-  std::map<std::string, int> type_counts;
-  for (const auto& e : list) {
-    type_counts[e.fd_type_name] += 1;
+static FlMethodResponse* HandleCancelFdCollection(FlMethodCall* method_call) {
+  gint64 request_id = 0;
+  if (!LookupNumberArg(fl_method_call_get_args(method_call), "requestId", &request_id)) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("invalid_args", "Expected 'requestId' as a number", nullptr));
   }
-  for (const auto& kv : type_counts) {
-    out << "  " << kv.first << ": " << kv.second << "\n";
+  auto cancelled = FindCollection(request_id);
+  if (cancelled) {
+    cancelled->store(true);
   }
+  g_autoptr(FlValue) result = fl_value_new_bool(cancelled != nullptr);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
 
-  out << "\nfd_details:\n";
-  for (const auto& e : list) {
-    std::string cloexec = FdFlagsString(e.fd);
-    std::string open = OpenFlagsString(e.fd);
-
-    if (e.fd_type == FD_TYPE_SOCKET) {
-      std::vector<std::string> parts;
-      parts.push_back("fd=" + std::to_string(e.fd));
-      parts.push_back(std::string("type=") + e.fd_type_name);
-      if (e.socket.has_so_type) {
-        parts.push_back("so_type=" + std::to_string(e.socket.so_type));
-      }
-      if (e.socket.has_so_proto) {
-        parts.push_back("so_proto=" + std::to_string(e.socket.so_proto));
-      }
-      if (e.socket.has_family) {
-        parts.push_back("family=" + std::to_string(e.socket.family));
-      }
-      if (!open.empty()) {
-        parts.push_back("open=" + open);
-      }
-      if (!cloexec.empty()) {
-        parts.push_back("fdflag=" + cloexec);
-      }
-      if (!e.socket.local.empty()) {
-        parts.push_back("local=" + e.socket.local);
-      }
-      if (!e.socket.peer.empty()) {
-        parts.push_back("peer=" + e.socket.peer);
-      }
-      if (e.socket.has_tcp_state) {
-        parts.push_back("tcp_state=" + e.socket.tcp_state_name + "(" + std::to_string(e.socket.tcp_state) + ")");
-      }
-      for (size_t i = 0; i < parts.size(); i++) {
-        if (i > 0) out << ' ';
-        out << parts[i];
-      }
-      out << "\n";
-      continue;
+// Lists descriptors that would be inherited by an exec'd child.
+static FlMethodResponse* HandleGetNonCloexecFds(FlMethodCall* method_call) {
+  bool include_stdio = false;
+  FlValue* args = fl_method_call_get_args(method_call);
+  if (fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    FlValue* stdio_value = fl_value_lookup_string(args, "includeStdio");
+    if (stdio_value != nullptr && fl_value_get_type(stdio_value) == FL_VALUE_TYPE_BOOL) {
+      include_stdio = fl_value_get_bool(stdio_value);
     }
+  }
 
-    if (e.fd_type == FD_TYPE_VNODE) {
-      std::vector<std::string> parts;
-      parts.push_back("fd=" + std::to_string(e.fd));
-      parts.push_back(std::string("type=") + e.fd_type_name);
-      if (!open.empty()) {
-        parts.push_back("open=" + open);
-      }
-      if (!cloexec.empty()) {
-        parts.push_back("fdflag=" + cloexec);
-      }
-      if (!e.path.empty()) {
-        parts.push_back("path=" + e.path);
-      }
-      if (e.vnode.present) {
-        std::ostringstream mode;
-        mode << std::oct << (unsigned int)e.vnode.mode;
-        parts.push_back("mode=" + mode.str());
-        parts.push_back("size=" + std::to_string(e.vnode.size));
-      }
-      for (size_t i = 0; i < parts.size(); i++) {
-        if (i > 0) out << ' ';
-        out << parts[i];
-      }
-      out << "\n";
+  auto snapshot = GetSnapshot(method_call);
+  std::vector<FdEntry> leaking;
+  for (const auto& e : snapshot->entries) {
+    if (e.fd_flags < 0 || (e.fd_flags & FD_CLOEXEC) != 0) {
+      continue;
+    }
+    if (!include_stdio && e.fd <= STDERR_FILENO) {
       continue;
     }
+    leaking.push_back(e);
+  }
+  g_autoptr(FlValue) result = BuildFdListValue(leaking);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static const char* FileUsageStateName(FileUsageState state) {
+  switch (state) {
+    case FILE_USAGE_MAPPED_ONLY:
+      return "mapped";
+    case FILE_USAGE_OPEN_AND_MAPPED:
+      return "both";
+    case FILE_USAGE_OPEN_ONLY:
+    default:
+      return "open";
+  }
+}
+
+static FlMethodResponse* HandleGetFileUsage(FlMethodCall* /*method_call*/) {
+  std::vector<FdEntry> entries;
+  FileUsageReport report = CollectFileUsage(&entries);
 
-    std::vector<std::string> parts;
-    parts.push_back("fd=" + std::to_string(e.fd));
-    parts.push_back(std::string("type=") + e.fd_type_name);
-    if (!open.empty()) {
-      parts.push_back("open=" + open);
+  g_autoptr(FlValue) result = fl_value_new_map();
+  FlValue* files = fl_value_new_list();
+  for (const auto& u : report.files) {
+    FlValue* map = fl_value_new_map();
+    fl_value_set_string_take(map, "dev", fl_value_new_int(static_cast<gint64>(u.dev)));
+    fl_value_set_string_take(map, "inode", fl_value_new_int(static_cast<gint64>(u.inode)));
+    fl_value_set_string_take(map, "path", fl_value_new_string(u.path.c_str()));
+    fl_value_set_string_take(map, "state", fl_value_new_string(FileUsageStateName(u.state)));
+    fl_value_set_string_take(map, "deleted", fl_value_new_bool(u.deleted));
+    FlValue* fds = fl_value_new_list();
+    for (int fd : u.fds) {
+      fl_value_append_take(fds, fl_value_new_int(fd));
     }
-    if (!cloexec.empty()) {
-      parts.push_back("fdflag=" + cloexec);
+    fl_value_set_string_take(map, "fds", fds);
+    fl_value_set_string_take(map, "mappingCount", fl_value_new_int(u.mapping_count));
+    fl_value_set_string_take(map, "mappedBytes", fl_value_new_int(u.mapped_bytes));
+    if (u.size >= 0) {
+      fl_value_set_string_take(map, "size", fl_value_new_int(u.size));
+      fl_value_set_string_take(map, "diskBytes", fl_value_new_int(u.disk_bytes));
+    } else {
+      fl_value_set_string_take(map, "size", fl_value_new_null());
+      fl_value_set_string_take(map, "diskBytes", fl_value_new_null());
     }
-    if (!e.path.empty()) {
-      parts.push_back("path=" + e.path);
+    fl_value_set_string_take(map, "reclaimableBytes", fl_value_new_int(u.reclaimable_bytes));
+    fl_value_append_take(files, map);
+  }
+  fl_value_set_string_take(result, "files", files);
+  fl_value_set_string_take(result, "deletedFileCount", fl_value_new_int(report.deleted_file_count));
+  fl_value_set_string_take(result, "deletedReclaimableBytes", fl_value_new_int(report.deleted_reclaimable_bytes));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static FlMethodResponse* HandleGetUnixSocketPeers(FlMethodCall* method_call) {
+  auto snapshot = GetSnapshot(method_call);
+  UnixPeerReport report = CollectUnixSocketPeers(snapshot->entries);
+
+  g_autoptr(FlValue) result = fl_value_new_map();
+  FlValue* sockets = fl_value_new_list();
+  for (const auto& s : report.sockets) {
+    FlValue* map = fl_value_new_map();
+    fl_value_set_string_take(map, "fd", fl_value_new_int(s.fd));
+    fl_value_set_string_take(map, "inode", fl_value_new_int(static_cast<gint64>(s.inode)));
+    fl_value_set_string_take(map, "local", fl_value_new_string(s.local.c_str()));
+    if (s.peer_inode != 0) {
+      fl_value_set_string_take(map, "peerInode", fl_value_new_int(static_cast<gint64>(s.peer_inode)));
+    } else {
+      fl_value_set_string_take(map, "peerInode", fl_value_new_null());
     }
-    for (size_t i = 0; i < parts.size(); i++) {
-      if (i > 0) out << ' ';
-      out << parts[i];
+    if (s.peer_pid >= 0) {
+      fl_value_set_string_take(map, "peerPid", fl_value_new_int(s.peer_pid));
+      fl_value_set_string_take(map, "peerFd", fl_value_new_int(s.peer_fd));
+      fl_value_set_string_take(map, "peerComm", fl_value_new_string(s.peer_comm.c_str()));
+    } else {
+      fl_value_set_string_take(map, "peerPid", fl_value_new_null());
+      fl_value_set_string_take(map, "peerFd", fl_value_new_null());
+      fl_value_set_string_take(map, "peerComm", fl_value_new_null());
     }
-    out << "\n";
+    fl_value_append_take(sockets, map);
   }
-
-  return out.str();
+  fl_value_set_string_take(result, "sockets", sockets);
+  fl_value_set_string_take(result, "diagErrno", fl_value_new_int(report.diag_errno));
+  fl_value_set_string_take(result, "processesScanned", fl_value_new_int(report.processes_scanned));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
-struct _FlutterFdUtilsPlugin {
-  GObject parent_instance;
-};
+static FlMethodResponse* HandleFdRange(FlMethodCall* method_call, bool close_fds) {
+  FlValue* args = fl_method_call_get_args(method_call);
+  gint64 first = 0;
+  if (!LookupNumberArg(args, "first", &first) || first < 0) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("invalid_args", "Expected 'first' as a non-negative number", nullptr));
+  }
+  gint64 last = UINT_MAX;
+  if (LookupNumberArg(args, "last", &last) && (last < first)) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("invalid_args", "Expected 'last' >= 'first'", nullptr));
+  }
+  unsigned int lo = first > UINT_MAX ? UINT_MAX : static_cast<unsigned int>(first);
+  unsigned int hi = last > UINT_MAX ? UINT_MAX : static_cast<unsigned int>(last);
 
-G_DEFINE_TYPE(FlutterFdUtilsPlugin, flutter_fd_utils_plugin, g_object_get_type())
+  FdRangeResult r = close_fds ? CloseRange(lo, hi) : SetCloexecRange(lo, hi);
+  FdSnapshotCache::Instance().Invalidate();
 
-static FlMethodResponse* HandleGetFdReport() {
-  auto list = CollectFdList();
-  std::string report = BuildFdReport(list);
-  g_autoptr(FlValue) result = fl_value_new_string(report.c_str());
-  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+  g_autoptr(FlValue) map = fl_value_new_map();
+  fl_value_set_string_take(map, "success", fl_value_new_bool(r.success));
+  fl_value_set_string_take(map, "usedCloseRange", fl_value_new_bool(r.used_close_range));
+  if (r.affected >= 0) {
+    fl_value_set_string_take(map, "affected", fl_value_new_int(r.affected));
+  } else {
+    fl_value_set_string_take(map, "affected", fl_value_new_null());
+  }
+  fl_value_set_string_take(map, "errno", fl_value_new_int(r.err));
+  fl_value_set_string_take(map, "errorMessage", fl_value_new_string(r.err != 0 ? strerror(r.err) : ""));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(map));
+}
+
+static FlMethodResponse* HandleSetSnapshotCacheMaxAge(FlMethodCall* method_call) {
+  gint64 max_age_ms = 0;
+  if (!LookupNumberArg(fl_method_call_get_args(method_call), "maxAgeMs", &max_age_ms) || max_age_ms < 0) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("invalid_args", "Expected 'maxAgeMs' as a non-negative number", nullptr));
+  }
+  FdSnapshotCache::Instance().SetDefaultMaxAge(std::chrono::milliseconds(max_age_ms));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
 }
 
-static FlMethodResponse* HandleGetFdList() {
-  auto list = CollectFdList();
-  g_autoptr(FlValue) result = BuildFdListValue(list);
+// Returns the backend that passes will actually use: "io_uring" only if the
+// ring can be set up in this process.
+static FlMethodResponse* HandleSetFdProbeBackend(FlMethodCall* method_call) {
+  FlValue* args = fl_method_call_get_args(method_call);
+  FlValue* value = args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_MAP
+                       ? fl_value_lookup_string(args, "backend")
+                       : nullptr;
+  const char* name = value != nullptr && fl_value_get_type(value) == FL_VALUE_TYPE_STRING
+                         ? fl_value_get_string(value)
+                         : "";
+  FdProbeBackend backend;
+  if (strcmp(name, "io_uring") == 0) {
+    backend = FdUringProber::Available() ? FD_PROBE_IO_URING : FD_PROBE_SYSCALLS;
+  } else if (strcmp(name, "syscalls") == 0) {
+    backend = FD_PROBE_SYSCALLS;
+  } else {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("invalid_args", "Expected 'backend' as 'io_uring' or 'syscalls'", nullptr));
+  }
+  SetDefaultProbeBackend(backend);
+  g_autoptr(FlValue) result = fl_value_new_string(backend == FD_PROBE_IO_URING ? "io_uring" : "syscalls");
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
+static FlMethodResponse* HandleSetFdConsistencyMode(FlMethodCall* method_call) {
+  FlValue* args = fl_method_call_get_args(method_call);
+  FlValue* value = args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_MAP
+                       ? fl_value_lookup_string(args, "mode")
+                       : nullptr;
+  const char* name = value != nullptr && fl_value_get_type(value) == FL_VALUE_TYPE_STRING
+                         ? fl_value_get_string(value)
+                         : "";
+  FdConsistencyMode mode;
+  if (strcmp(name, "off") == 0) {
+    mode = FD_CONSISTENCY_OFF;
+  } else if (strcmp(name, "mark") == 0) {
+    mode = FD_CONSISTENCY_MARK;
+  } else if (strcmp(name, "retry") == 0) {
+    mode = FD_CONSISTENCY_RETRY;
+  } else {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("invalid_args", "Expected 'mode' as 'off', 'mark' or 'retry'", nullptr));
+  }
+  SetDefaultConsistencyMode(mode);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
 static FlMethodResponse* HandleGetNofileLimit(const std::string& method) {
   struct rlimit lim;
   if (getrlimit(RLIMIT_NOFILE, &lim) != 0) {
@@ -583,6 +574,57 @@ static FlMethodResponse* HandleGetNofileLimit(const std::string& method) {
   return FL_METHOD_RESPONSE(fl_method_success_response_new(map));
 }
 
+// Encodes one used/limit pair; unknown values (-1) become null.
+static FlValue* BuildPressureMap(long long used, long long limit) {
+  FlValue* map = fl_value_new_map();
+  fl_value_set_string_take(map, "used", used >= 0 ? fl_value_new_int(used) : fl_value_new_null());
+  fl_value_set_string_take(map, "limit", limit >= 0 ? fl_value_new_int(limit) : fl_value_new_null());
+  double headroom = HeadroomRatio(used, limit);
+  fl_value_set_string_take(map, "headroom", headroom >= 0 ? fl_value_new_float(headroom) : fl_value_new_null());
+  return map;
+}
+
+static FlMethodResponse* HandleGetFdPressure(FlMethodCall* /*method_call*/) {
+  FdPressure p = ReadFdPressure();
+
+  g_autoptr(FlValue) map = fl_value_new_map();
+  fl_value_set_string_take(map, "processFds", BuildPressureMap(p.process_fds, p.nofile_soft));
+  fl_value_set_string_take(map, "nofileHard", p.nofile_hard >= 0 ? fl_value_new_int(p.nofile_hard) : fl_value_new_null());
+  fl_value_set_string_take(map, "systemFiles", BuildPressureMap(p.system_files_allocated, p.system_files_max));
+  fl_value_set_string_take(map, "inotifyInstances", BuildPressureMap(p.inotify_instances, p.inotify_max_user_instances));
+  fl_value_set_string_take(map, "inotifyWatches", BuildPressureMap(p.inotify_watches, p.inotify_max_user_watches));
+  fl_value_set_string_take(map, "epollInstances", fl_value_new_int(p.epoll_instances));
+  fl_value_set_string_take(map, "epollWatches", BuildPressureMap(p.epoll_watches, p.epoll_max_user_watches));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(map));
+}
+
+static FlMethodResponse* HandleGetCollectorStats(FlMethodCall* method_call) {
+  FdCollectorStats& stats = FdCollectorStats::Instance();
+  FdCollectorStats::Window window = stats.Read();
+
+  FlValue* args = fl_method_call_get_args(method_call);
+  if (fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    FlValue* reset = fl_value_lookup_string(args, "reset");
+    if (reset != nullptr && fl_value_get_type(reset) == FL_VALUE_TYPE_BOOL && fl_value_get_bool(reset)) {
+      stats.Reset();
+    }
+  }
+
+  g_autoptr(FlValue) map = fl_value_new_map();
+  fl_value_set_string_take(map, "windowMs", fl_value_new_int(window.window_ms));
+  FlValue* phases = fl_value_new_map();
+  for (int phase = 0; phase < FD_PHASE_COUNT; phase++) {
+    fl_value_set_string_take(phases, FdPhaseName(phase), BuildHistogramMap(window.phases[phase]));
+  }
+  fl_value_set_string_take(map, "phases", phases);
+  FlValue* methods = fl_value_new_map();
+  for (const auto& kv : window.methods) {
+    fl_value_set_string_take(methods, kv.first.c_str(), BuildHistogramMap(kv.second));
+  }
+  fl_value_set_string_take(map, "methods", methods);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(map));
+}
+
 static FlMethodResponse* HandleSetNofileSoftLimit(FlMethodCall* method_call) {
   FlValue* args = fl_method_call_get_args(method_call);
   FlValue* soft_limit_value = nullptr;
@@ -664,28 +706,408 @@ static FlMethodResponse* HandleSetNofileSoftLimit(FlMethodCall* method_call) {
   return FL_METHOD_RESPONSE(fl_method_success_response_new(map));
 }
 
+static FlMethodResponse* HandleEnableEmergencyFdDump(FlMethodCall* method_call) {
+  FlValue* args = fl_method_call_get_args(method_call);
+  if (fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("invalid_args", "Expected a map of arguments", nullptr));
+  }
+
+  FlValue* path_value = fl_value_lookup_string(args, "path");
+  if (path_value == nullptr || fl_value_get_type(path_value) != FL_VALUE_TYPE_STRING ||
+      fl_value_get_string(path_value)[0] == '\0') {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("invalid_args", "Expected 'path' as a non-empty string", nullptr));
+  }
+
+  FdEmergencyDumpConfig config;
+  config.path = fl_value_get_string(path_value);
+
+  FlValue* signal_value = fl_value_lookup_string(args, "triggerSignal");
+  if (signal_value != nullptr && fl_value_get_type(signal_value) == FL_VALUE_TYPE_INT) {
+    gint64 sig = fl_value_get_int(signal_value);
+    if (sig <= 0 || sig >= NSIG || sig == SIGKILL || sig == SIGSTOP) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("invalid_args", "'triggerSignal' is not a catchable signal", nullptr));
+    }
+    config.trigger_signal = static_cast<int>(sig);
+  }
+
+  FlValue* fatal_value = fl_value_lookup_string(args, "dumpOnFatalSignal");
+  if (fatal_value != nullptr && fl_value_get_type(fatal_value) == FL_VALUE_TYPE_BOOL) {
+    config.dump_on_fatal_signal = fl_value_get_bool(fatal_value);
+  }
+  FlValue* emfile_value = fl_value_lookup_string(args, "dumpOnEmfile");
+  if (emfile_value != nullptr && fl_value_get_type(emfile_value) == FL_VALUE_TYPE_BOOL) {
+    config.dump_on_emfile = fl_value_get_bool(emfile_value);
+  }
+
+  int err = 0;
+  if (!FdEmergencyDumpInstall(config, &err)) {
+    g_autoptr(FlValue) details = fl_value_new_map();
+    fl_value_set_string_take(details, "errno", fl_value_new_int(err));
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("emergency_dump_failed", strerror(err), details));
+  }
+
+  g_autoptr(FlValue) result = fl_value_new_null();
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Stopping a running publisher waits out its in-flight monitor sample, which
+// may be a full collection, so both shm handlers run off the main thread.
+static FlMethodResponse* HandleEnableShmPublisher(FlMethodCall* method_call) {
+  FlValue* args = fl_method_call_get_args(method_call);
+  FdShmPublisherConfig config;
+  if (fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    FlValue* name = fl_value_lookup_string(args, "name");
+    if (name != nullptr && fl_value_get_type(name) == FL_VALUE_TYPE_STRING) {
+      config.name = fl_value_get_string(name);
+    }
+  }
+  gint64 value = 0;
+  if (LookupNumberArg(args, "intervalMs", &value)) {
+    if (value <= 0) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("invalid_args", "Expected 'intervalMs' > 0", nullptr));
+    }
+    config.interval = std::chrono::milliseconds(value);
+  }
+  if (LookupNumberArg(args, "capacity", &value)) {
+    if (value <= 0) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("invalid_args", "Expected 'capacity' > 0", nullptr));
+    }
+    config.capacity = static_cast<size_t>(value);
+  }
+
+  FdShmPublisherInfo info;
+  int err = 0;
+  if (!FdShmPublisherStart(config, &info, &err)) {
+    g_autoptr(FlValue) details = fl_value_new_map();
+    fl_value_set_string_take(details, "errno", fl_value_new_int(err));
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("shm_publisher_failed", strerror(err), details));
+  }
+
+  g_autoptr(FlValue) map = fl_value_new_map();
+  fl_value_set_string_take(map, "path", fl_value_new_string(info.path.c_str()));
+  fl_value_set_string_take(map, "fd", fl_value_new_int(info.fd));
+  fl_value_set_string_take(map, "segmentSize", fl_value_new_int(static_cast<gint64>(info.segment_size)));
+  fl_value_set_string_take(map, "capacity", fl_value_new_int(static_cast<gint64>(info.capacity)));
+  fl_value_set_string_take(map, "intervalMs", fl_value_new_int(info.interval.count()));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(map));
+}
+
+static FlMethodResponse* HandleDisableShmPublisher(FlMethodCall* /*method_call*/) {
+  FdShmPublisherStop();
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+static FlValue* BuildTraceInfoMap(const FdTraceInfo& info) {
+  FlValue* map = fl_value_new_map();
+  fl_value_set_string_take(map, "active", fl_value_new_bool(info.active));
+  fl_value_set_string_take(map, "path", fl_value_new_string(info.path.c_str()));
+  fl_value_set_string_take(map, "intervalMs", fl_value_new_int(info.interval.count()));
+  fl_value_set_string_take(map, "maxBytes", fl_value_new_int(info.max_bytes));
+  fl_value_set_string_take(map, "bytesWritten", fl_value_new_int(info.bytes_written));
+  fl_value_set_string_take(map, "samples", fl_value_new_int(info.samples));
+  fl_value_set_string_take(map, "opened", fl_value_new_int(info.opened));
+  fl_value_set_string_take(map, "closed", fl_value_new_int(info.closed));
+  fl_value_set_string_take(map, "truncated", fl_value_new_bool(info.truncated));
+  fl_value_set_string_take(map, "writeErrno", fl_value_new_int(info.write_errno));
+  return map;
+}
+
+static FlMethodResponse* HandleStartFdTrace(FlMethodCall* method_call) {
+  FlValue* args = fl_method_call_get_args(method_call);
+  FdTraceConfig config;
+  FlValue* path = fl_value_get_type(args) == FL_VALUE_TYPE_MAP ? fl_value_lookup_string(args, "path") : nullptr;
+  if (path == nullptr || fl_value_get_type(path) != FL_VALUE_TYPE_STRING || fl_value_get_string(path)[0] == '\0') {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("invalid_args", "Expected non-empty 'path'", nullptr));
+  }
+  config.path = fl_value_get_string(path);
+  gint64 value = 0;
+  if (LookupNumberArg(args, "intervalMs", &value)) {
+    if (value <= 0) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("invalid_args", "Expected 'intervalMs' > 0", nullptr));
+    }
+    config.interval = std::chrono::milliseconds(value);
+  }
+  if (LookupNumberArg(args, "maxBytes", &value)) {
+    config.max_bytes = value;
+  }
+
+  FdTraceInfo info;
+  int err = 0;
+  if (!FdTraceStart(config, &info, &err)) {
+    g_autoptr(FlValue) details = fl_value_new_map();
+    fl_value_set_string_take(details, "errno", fl_value_new_int(err));
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("fd_trace_failed", strerror(err), details));
+  }
+  g_autoptr(FlValue) map = BuildTraceInfoMap(info);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(map));
+}
+
+// Waits for an in-flight sample before finishing the file, so it runs off the
+// main thread.
+static FlMethodResponse* HandleStopFdTrace(FlMethodCall* method_call) {
+  g_autoptr(FlValue) map = BuildTraceInfoMap(FdTraceStop());
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(map));
+}
+
+static FlMethodResponse* HandleTriggerEmergencyFdDump() {
+  long written = FdEmergencyDumpWrite("manual");
+  if (written < 0) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("emergency_dump_unavailable", "Emergency fd dump is not enabled or is already running", nullptr));
+  }
+  g_autoptr(FlValue) result = fl_value_new_int(written);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Collection can take a while on large fd tables, so those handlers run on
+// the GLib worker pool and respond back on the main thread. Running them
+// concurrently is what lets FdSnapshotCache coalesce overlapping requests.
+typedef FlMethodResponse* (*BackgroundHandler)(FlMethodCall* method_call);
+
+struct BackgroundCall {
+  FlMethodCall* method_call;
+  BackgroundHandler handler;
+};
+
+static void BackgroundCallFree(gpointer data) {
+  BackgroundCall* call = static_cast<BackgroundCall*>(data);
+  g_object_unref(call->method_call);
+  delete call;
+}
+
+static void BackgroundCallThread(GTask* task, gpointer /*source*/, gpointer task_data, GCancellable* /*cancellable*/) {
+  BackgroundCall* call = static_cast<BackgroundCall*>(task_data);
+  long long start = MonotonicNowNs();
+  FlMethodResponse* response = call->handler(call->method_call);
+  FdCollectorStats::Instance().RecordMethod(fl_method_call_get_name(call->method_call), MonotonicNowNs() - start);
+  g_task_return_pointer(task, response, g_object_unref);
+}
+
+static void BackgroundCallDone(GObject* /*source*/, GAsyncResult* result, gpointer /*user_data*/) {
+  GTask* task = G_TASK(result);
+  BackgroundCall* call = static_cast<BackgroundCall*>(g_task_get_task_data(task));
+  g_autoptr(FlMethodResponse) response = FL_METHOD_RESPONSE(g_task_propagate_pointer(task, nullptr));
+  fl_method_call_respond(call->method_call, response, nullptr);
+}
+
+static void RespondInBackground(FlutterFdUtilsPlugin* self, FlMethodCall* method_call, BackgroundHandler handler) {
+  g_autoptr(GTask) task = g_task_new(self, nullptr, BackgroundCallDone, nullptr);
+  g_task_set_task_data(task, new BackgroundCall{FL_METHOD_CALL(g_object_ref(method_call)), handler}, BackgroundCallFree);
+  g_task_run_in_thread(task, BackgroundCallThread);
+}
+
+// One listen() on the report stream channel. The worker renders NDJSON into a
+// chunk buffer and hands each filled chunk to the main loop, waiting for the
+// previous one to be sent first, so at most one chunk is in flight while the
+// next is being filled.
+struct ReportStream {
+  FlEventChannel* channel;
+  size_t chunk_size;
+  std::atomic<bool> cancelled{false};
+  std::mutex mutex;
+  std::condition_variable delivered;
+  bool in_flight = false;
+
+  ~ReportStream() { g_object_unref(channel); }
+};
+
+struct ReportStreamMessage {
+  std::shared_ptr<ReportStream> stream;
+  // nullptr marks end of stream.
+  FlValue* chunk;
+};
+
+static constexpr size_t kMinReportChunkSize = 4 * 1024;
+static constexpr size_t kMaxReportChunkSize = 4 * 1024 * 1024;
+
+// Only touched on the main thread.
+static std::shared_ptr<ReportStream>& ActiveReportStream() {
+  static std::shared_ptr<ReportStream>* stream = new std::shared_ptr<ReportStream>();
+  return *stream;
+}
+
+static gboolean DeliverReportStreamMessage(gpointer data) {
+  ReportStreamMessage* message = static_cast<ReportStreamMessage*>(data);
+  ReportStream* stream = message->stream.get();
+  if (!stream->cancelled.load()) {
+    if (message->chunk != nullptr) {
+      fl_event_channel_send(stream->channel, message->chunk, nullptr, nullptr);
+    } else {
+      fl_event_channel_send_end_of_stream(stream->channel, nullptr, nullptr);
+    }
+  }
+  if (message->chunk != nullptr) {
+    fl_value_unref(message->chunk);
+  }
+  {
+    std::lock_guard<std::mutex> lock(stream->mutex);
+    stream->in_flight = false;
+  }
+  stream->delivered.notify_all();
+  delete message;
+  return G_SOURCE_REMOVE;
+}
+
+// Waits for the previous message to be delivered, then posts |chunk|.
+// Returns false once the listener has cancelled.
+static bool PostReportStreamMessage(const std::shared_ptr<ReportStream>& stream, FlValue* chunk) {
+  std::unique_lock<std::mutex> lock(stream->mutex);
+  stream->delivered.wait(lock, [&stream] { return !stream->in_flight || stream->cancelled.load(); });
+  if (stream->cancelled.load()) {
+    if (chunk != nullptr) fl_value_unref(chunk);
+    return false;
+  }
+  stream->in_flight = true;
+  lock.unlock();
+  g_main_context_invoke(nullptr, DeliverReportStreamMessage, new ReportStreamMessage{stream, chunk});
+  return true;
+}
+
+static void ReportStreamThread(GTask* /*task*/, gpointer /*source*/, gpointer task_data, GCancellable* /*cancellable*/) {
+  std::shared_ptr<ReportStream> stream = *static_cast<std::shared_ptr<ReportStream>*>(task_data);
+
+  FdReportStreamOptions options;
+  options.chunk_size = stream->chunk_size;
+  options.cancelled = &stream->cancelled;
+  long long start = MonotonicNowNs();
+  StreamFdReport(options, [&stream](const char* data, size_t len) {
+    return PostReportStreamMessage(stream, fl_value_new_uint8_list(reinterpret_cast<const uint8_t*>(data), len));
+  });
+  FdCollectorStats::Instance().RecordMethod("streamFdReport", MonotonicNowNs() - start);
+  PostReportStreamMessage(stream, nullptr);
+}
+
+static void ReportStreamTaskDataFree(gpointer data) {
+  delete static_cast<std::shared_ptr<ReportStream>*>(data);
+}
+
+static FlMethodErrorResponse* ReportStreamListen(FlEventChannel* channel, FlValue* args, gpointer /*user_data*/) {
+  std::shared_ptr<ReportStream>& active = ActiveReportStream();
+  if (active) {
+    active->cancelled.store(true);
+    active->delivered.notify_all();
+  }
+
+  gint64 chunk_size = 64 * 1024;
+  LookupNumberArg(args, "chunkSize", &chunk_size);
+  if (chunk_size < static_cast<gint64>(kMinReportChunkSize)) chunk_size = kMinReportChunkSize;
+  if (chunk_size > static_cast<gint64>(kMaxReportChunkSize)) chunk_size = kMaxReportChunkSize;
+
+  active = std::make_shared<ReportStream>();
+  active->channel = FL_EVENT_CHANNEL(g_object_ref(channel));
+  active->chunk_size = static_cast<size_t>(chunk_size);
+
+  g_autoptr(GTask) task = g_task_new(nullptr, nullptr, nullptr, nullptr);
+  g_task_set_task_data(task, new std::shared_ptr<ReportStream>(active), ReportStreamTaskDataFree);
+  g_task_run_in_thread(task, ReportStreamThread);
+  return nullptr;
+}
+
+static FlMethodErrorResponse* ReportStreamCancel(FlEventChannel* /*channel*/, FlValue* /*args*/, gpointer /*user_data*/) {
+  std::shared_ptr<ReportStream>& active = ActiveReportStream();
+  if (active) {
+    active->cancelled.store(true);
+    active->delivered.notify_all();
+    active.reset();
+  }
+  return nullptr;
+}
+
 static void flutter_fd_utils_plugin_handle_method_call(FlutterFdUtilsPlugin* self, FlMethodCall* method_call) {
   const gchar* method = fl_method_call_get_name(method_call);
 
-  FlMethodResponse* response = nullptr;
   if (strcmp(method, "getFdReport") == 0) {
-    response = HandleGetFdReport();
-  } else if (strcmp(method, "getFdList") == 0) {
-    response = HandleGetFdList();
-  } else if (strcmp(method, "getNofileLimit") == 0 ||
-             strcmp(method, "getNofileSoftLimit") == 0 ||
-             strcmp(method, "getNofileHardLimit") == 0) {
+    RegisterCollection(method_call);
+    RespondInBackground(self, method_call, HandleGetFdReport);
+    return;
+  }
+  if (strcmp(method, "getFdListPage") == 0) {
+    RegisterCollection(method_call);
+    RespondInBackground(self, method_call, HandleGetFdListPage);
+    return;
+  }
+  if (strcmp(method, "getFdList") == 0) {
+    RespondInBackground(self, method_call, HandleGetFdList);
+    return;
+  }
+  if (strcmp(method, "getFdSnapshot") == 0) {
+    RespondInBackground(self, method_call, HandleGetFdSnapshot);
+    return;
+  }
+
+  if (strcmp(method, "getFileUsage") == 0) {
+    RespondInBackground(self, method_call, HandleGetFileUsage);
+    return;
+  }
+  if (strcmp(method, "getNonCloexecFds") == 0) {
+    RespondInBackground(self, method_call, HandleGetNonCloexecFds);
+    return;
+  }
+  if (strcmp(method, "enableShmPublisher") == 0) {
+    RespondInBackground(self, method_call, HandleEnableShmPublisher);
+    return;
+  }
+  if (strcmp(method, "disableShmPublisher") == 0) {
+    RespondInBackground(self, method_call, HandleDisableShmPublisher);
+    return;
+  }
+  if (strcmp(method, "stopFdTrace") == 0) {
+    RespondInBackground(self, method_call, HandleStopFdTrace);
+    return;
+  }
+  if (strcmp(method, "getUnixSocketPeers") == 0) {
+    RespondInBackground(self, method_call, HandleGetUnixSocketPeers);
+    return;
+  }
+  if (strcmp(method, "getFdPressure") == 0) {
+    RespondInBackground(self, method_call, HandleGetFdPressure);
+    return;
+  }
+
+  long long start = MonotonicNowNs();
+  FlMethodResponse* response = nullptr;
+  if (strcmp(method, "getNofileLimit") == 0 ||
+      strcmp(method, "getNofileSoftLimit") == 0 ||
+      strcmp(method, "getNofileHardLimit") == 0) {
     response = HandleGetNofileLimit(method);
   } else if (strcmp(method, "setNofileSoftLimit") == 0) {
     response = HandleSetNofileSoftLimit(method_call);
+  } else if (strcmp(method, "setCloexecRange") == 0) {
+    response = HandleFdRange(method_call, false);
+  } else if (strcmp(method, "closeRange") == 0) {
+    response = HandleFdRange(method_call, true);
+  } else if (strcmp(method, "cancelFdCollection") == 0) {
+    response = HandleCancelFdCollection(method_call);
+  } else if (strcmp(method, "getCollectorStats") == 0) {
+    response = HandleGetCollectorStats(method_call);
+  } else if (strcmp(method, "setSnapshotCacheMaxAge") == 0) {
+    response = HandleSetSnapshotCacheMaxAge(method_call);
+  } else if (strcmp(method, "setFdProbeBackend") == 0) {
+    response = HandleSetFdProbeBackend(method_call);
+  } else if (strcmp(method, "setFdConsistencyMode") == 0) {
+    response = HandleSetFdConsistencyMode(method_call);
+  } else if (strcmp(method, "enableEmergencyFdDump") == 0) {
+    response = HandleEnableEmergencyFdDump(method_call);
+  } else if (strcmp(method, "disableEmergencyFdDump") == 0) {
+    FdEmergencyDumpUninstall();
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+  } else if (strcmp(method, "triggerEmergencyFdDump") == 0) {
+    response = HandleTriggerEmergencyFdDump();
+  } else if (strcmp(method, "startFdTrace") == 0) {
+    response = HandleStartFdTrace(method_call);
+  } else if (strcmp(method, "getFdTraceInfo") == 0) {
+    g_autoptr(FlValue) map = BuildTraceInfoMap(FdTraceGetInfo());
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(map));
   } else {
     response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
   }
+  FdCollectorStats::Instance().RecordMethod(method, MonotonicNowNs() - start);
 
   fl_method_call_respond(method_call, response, nullptr);
 }
 
 static void flutter_fd_utils_plugin_dispose(GObject* object) {
+  FlutterFdUtilsPlugin* self = FLUTTER_FD_UTILS_PLUGIN(object);
+  g_clear_object(&self->report_stream_channel);
   G_OBJECT_CLASS(flutter_fd_utils_plugin_parent_class)->dispose(object);
 }
 
@@ -711,5 +1133,11 @@ void flutter_fd_utils_plugin_register_with_registrar(FlPluginRegistrar* registra
       FL_METHOD_CODEC(codec));
 
   fl_method_channel_set_method_call_handler(channel, method_call_cb, g_object_ref(plugin), g_object_unref);
+
+  plugin->report_stream_channel = fl_event_channel_new(
+      fl_plugin_registrar_get_messenger(registrar),
+      "flutter_fd_utils/fd_report_stream",
+      FL_METHOD_CODEC(codec));
+  fl_event_channel_set_stream_handlers(plugin->report_stream_channel, ReportStreamListen, ReportStreamCancel, nullptr, nullptr);
   g_object_unref(plugin);
 }
@@ -0,0 +1,65 @@
+#ifndef FLUTTER_PLUGIN_FLUTTER_FD_UTILS_FFI_H_
+#define FLUTTER_PLUGIN_FLUTTER_FD_UTILS_FFI_H_
+
+#include <stdint.h>
+
+// Stable C ABI exported from libflutter_fd_utils_plugin.so for dart:ffi.
+//
+// These calls do not go through the method channel and may be made from any
+// thread or isolate. Functions returning int32_t report 0 on success or an
+// errno value on failure.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FLUTTER_FD_UTILS_EXPORT __attribute__((visibility("default"))) __attribute__((used))
+
+// Bumped whenever a signature or struct layout below changes.
+#define FLUTTER_FD_UTILS_FFI_ABI_VERSION 1
+
+// Every field is an int64_t so bindings can read the struct as an array.
+typedef struct {
+  int64_t fd_count;
+  int64_t vnode_count;
+  int64_t socket_count;
+  int64_t pipe_count;
+  int64_t unknown_count;
+  // Descriptors without FD_CLOEXEC, i.e. inherited across exec().
+  int64_t non_cloexec_count;
+  int64_t nofile_soft;
+  int64_t nofile_hard;
+  // Age of the snapshot the counts were taken from, in microseconds.
+  int64_t snapshot_age_us;
+} FlutterFdUtilsSummary;
+
+FLUTTER_FD_UTILS_EXPORT int32_t flutter_fd_utils_ffi_abi_version(void);
+
+// Counts open descriptors without building a snapshot. Returns a negative
+// errno value on failure.
+FLUTTER_FD_UTILS_EXPORT int64_t flutter_fd_utils_get_fd_count(void);
+
+FLUTTER_FD_UTILS_EXPORT int32_t flutter_fd_utils_get_nofile_limit(int64_t* soft, int64_t* hard);
+
+// Fills |out| from the shared snapshot cache, reusing a snapshot up to
+// |max_age_ms| old (negative means the cache default). Returns 0, an errno
+// value, or -1 if the collection failed.
+FLUTTER_FD_UTILS_EXPORT int32_t flutter_fd_utils_get_fd_summary(int64_t max_age_ms, FlutterFdUtilsSummary* out);
+
+// Writes a columnar snapshot into caller-provided arrays of |capacity|
+// elements; any column may be null. Returns the number of descriptors in the
+// snapshot, which may exceed |capacity| (only the first |capacity| rows are
+// written), or -1 if the collection failed. Missing F_GETFL / F_GETFD values
+// are written as -1.
+FLUTTER_FD_UTILS_EXPORT int64_t flutter_fd_utils_get_fd_snapshot(int64_t max_age_ms,
+                                                                 int32_t* fds,
+                                                                 int32_t* fd_types,
+                                                                 int32_t* open_flags,
+                                                                 int32_t* fd_flags,
+                                                                 int64_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // FLUTTER_PLUGIN_FLUTTER_FD_UTILS_FFI_H_
@@ -0,0 +1,130 @@
+#ifndef FLUTTER_PLUGIN_FLUTTER_FD_UTILS_SHM_H_
+#define FLUTTER_PLUGIN_FLUTTER_FD_UTILS_SHM_H_
+
+#include <stdint.h>
+
+// Binary layout of the shared-memory segment written by the fd publisher
+// (enableShmPublisher on the Dart side).
+//
+// The segment is a POSIX shm object (/dev/shm/<name>) or, when no name was
+// given, a memfd reachable as /proc/<pid>/fd/<n>. An external reader maps it
+// read-only and never calls into the publishing process:
+//
+//   +--------------------------------+ 0
+//   | FlutterFdUtilsShmHeader        |
+//   +--------------------------------+ header_size
+//   | FlutterFdUtilsShmEntry[capacity]|
+//   +--------------------------------+ segment_size
+//
+// All fields are native-endian and naturally aligned. The fields up to and
+// including |capacity| are written once before the segment is published and
+// never change. Everything after |sequence| is guarded by a seqlock:
+//
+//   1. s1 = atomic load-acquire of |sequence|; if s1 is odd a write is in
+//      progress, retry.
+//   2. Copy the header fields and the first |entry_count| entries.
+//   3. Acquire fence, then s2 = atomic load of |sequence|.
+//   4. If s1 != s2 the copy may be torn; retry from 1.
+//
+// flutter_fd_utils_shm_read() below implements this loop. |sequence| is 0
+// until the first snapshot is published.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// "FDSH" read as a little-endian uint32_t.
+#define FLUTTER_FD_UTILS_SHM_MAGIC 0x48534446u
+
+// Bumped whenever the layout below changes incompatibly.
+#define FLUTTER_FD_UTILS_SHM_LAYOUT_VERSION 1
+
+typedef struct {
+  // Immutable once published.
+  uint32_t magic;
+  uint32_t layout_version;
+  uint32_t header_size;
+  uint32_t entry_size;
+  uint64_t segment_size;
+  int64_t pid;
+  uint64_t capacity;
+
+  // Seqlock counter; odd while the publisher is writing.
+  uint64_t sequence;
+
+  // Guarded by |sequence|.
+  uint64_t publish_count;
+  // CLOCK_MONOTONIC and CLOCK_REALTIME of the snapshot.
+  int64_t captured_monotonic_ns;
+  int64_t published_unix_ms;
+  // Time the collection itself took.
+  int64_t collect_ns;
+  int64_t fd_count;
+  int64_t vnode_count;
+  int64_t socket_count;
+  int64_t pipe_count;
+  int64_t unknown_count;
+  int64_t non_cloexec_count;
+  int64_t nofile_soft;
+  int64_t nofile_hard;
+  // Entries that follow the header; less than fd_count when the snapshot did
+  // not fit in |capacity|.
+  uint64_t entry_count;
+  uint64_t reserved[13];
+} FlutterFdUtilsShmHeader;
+
+typedef struct {
+  int32_t fd;
+  // FD_TYPE_* value as reported by getFdList (1 vnode, 2 socket, 6 pipe).
+  int32_t fd_type;
+  // F_GETFL / F_GETFD results, or -1 when unavailable.
+  int32_t open_flags;
+  int32_t fd_flags;
+  uint64_t dev;
+  uint64_t inode;
+} FlutterFdUtilsShmEntry;
+
+// Copies a consistent header and up to |max_entries| entries out of a mapped
+// segment. Returns the number of entries copied, or -1 if the segment is not
+// a compatible layout or no snapshot has been published yet. Gives up with -1
+// after |max_attempts| torn reads.
+static inline int64_t flutter_fd_utils_shm_read(const void* segment,
+                                                FlutterFdUtilsShmHeader* header,
+                                                FlutterFdUtilsShmEntry* entries,
+                                                uint64_t max_entries,
+                                                int max_attempts) {
+  const FlutterFdUtilsShmHeader* shared = (const FlutterFdUtilsShmHeader*)segment;
+  if (shared->magic != FLUTTER_FD_UTILS_SHM_MAGIC || shared->layout_version != FLUTTER_FD_UTILS_SHM_LAYOUT_VERSION) {
+    return -1;
+  }
+  const FlutterFdUtilsShmEntry* shared_entries =
+      (const FlutterFdUtilsShmEntry*)((const char*)segment + shared->header_size);
+  for (int attempt = 0; attempt < max_attempts; attempt++) {
+    uint64_t s1 = __atomic_load_n(&shared->sequence, __ATOMIC_ACQUIRE);
+    if (s1 == 0) {
+      return -1;
+    }
+    if (s1 & 1) {
+      continue;
+    }
+    *header = *shared;
+    uint64_t n = header->entry_count;
+    if (n > header->capacity) n = header->capacity;
+    if (n > max_entries) n = max_entries;
+    for (uint64_t i = 0; i < n; i++) {
+      entries[i] = shared_entries[i];
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&shared->sequence, __ATOMIC_RELAXED) == s1) {
+      header->sequence = s1;
+      return (int64_t)n;
+    }
+  }
+  return -1;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // FLUTTER_PLUGIN_FLUTTER_FD_UTILS_SHM_H_
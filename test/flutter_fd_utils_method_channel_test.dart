@@ -1,5 +1,8 @@
+import 'dart:typed_data';
+
 import 'package:flutter/services.dart';
 import 'package:flutter_test/flutter_test.dart';
+import 'package:flutter_fd_utils/flutter_fd_utils.dart';
 import 'package:flutter_fd_utils/flutter_fd_utils_method_channel.dart';
 
 void main() {
@@ -7,12 +10,14 @@ void main() {
 
   MethodChannelFlutterFdUtils platform = MethodChannelFlutterFdUtils();
   const MethodChannel channel = MethodChannel('flutter_fd_utils');
+  Object? lastArguments;
 
   setUp(() {
     TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(
       channel,
       (MethodCall methodCall) async {
         if (methodCall.method == 'getFdReport') {
+          lastArguments = methodCall.arguments;
           return '42';
         }
         if (methodCall.method == 'getNofileLimit') {
@@ -50,6 +55,212 @@ void main() {
             'errorMessage': '',
           };
         }
+        if (methodCall.method == 'getFdListPage') {
+          lastArguments = methodCall.arguments;
+          return <String, Object?>{
+            'entries': <Object?>[
+              <String, Object?>{'fd': 7, 'fdType': 6, 'fdTypeName': 'PIPE'},
+            ],
+            'truncated': true,
+            'nextFd': 8,
+            'timings': <String, Object?>{'dir_scan': 4000, 'readlink': 12000},
+          };
+        }
+        if (methodCall.method == 'cancelFdCollection') {
+          lastArguments = methodCall.arguments;
+          return true;
+        }
+        if (methodCall.method == 'getCollectorStats') {
+          lastArguments = methodCall.arguments;
+          return <String, Object?>{
+            'windowMs': 60000,
+            'phases': <String, Object?>{
+              'fstat': <String, Object?>{
+                'count': 3,
+                'minNs': 1000,
+                'maxNs': 5000,
+                'meanNs': 3000,
+                'p50Ns': 3071,
+                'p90Ns': 5000,
+                'p99Ns': 5000,
+                'p999Ns': 5000,
+                'buckets': <Object?>[
+                  <Object?>[1023, 1],
+                  <Object?>[3071, 1],
+                  <Object?>[5119, 1],
+                ],
+              },
+              'bogus': <String, Object?>{'count': 1},
+            },
+            'methods': <String, Object?>{
+              'getFdList': <String, Object?>{'count': 1, 'p50Ns': 2000000},
+            },
+          };
+        }
+        if (methodCall.method == 'getFdSnapshot') {
+          lastArguments = methodCall.arguments;
+          return <String, Object?>{
+            'report': 'fd_count: 2\n',
+            'entries': <Object?>[
+              <String, Object?>{'fd': 0, 'fdType': 1, 'fdTypeName': 'VNODE', 'openFlags': 0, 'fdFlags': 0, 'path': '/dev/null'},
+              <String, Object?>{
+                'fd': 5,
+                'fdType': 2,
+                'fdTypeName': 'SOCKET',
+                'openFlags': 2,
+                'fdFlags': 1,
+                'path': 'socket:[99]',
+                'torn': true,
+                'socket': <String, Object?>{'family': 1, 'local': null, 'peer': null},
+              },
+            ],
+            'summary': <String, Object?>{
+              'fdCount': 2,
+              'vnodeCount': 1,
+              'socketCount': 1,
+              'pipeCount': 0,
+              'unknownCount': 0,
+              'nonCloexecCount': 1,
+              'nofileSoft': 1024,
+              'nofileHard': 524288,
+              'snapshotAgeUs': 1500,
+            },
+            'timings': <String, Object?>{'dir_scan': 1000, 'encode': 3000},
+          };
+        }
+        if (methodCall.method == 'getFdPressure') {
+          return <String, Object?>{
+            'processFds': <String, Object?>{'used': 12, 'limit': 1024, 'headroom': 0.98828125},
+            'nofileHard': 4096,
+            'systemFiles': <String, Object?>{'used': 3000, 'limit': 600000, 'headroom': 0.995},
+            'inotifyInstances': <String, Object?>{'used': 1, 'limit': 128, 'headroom': 0.9921875},
+            'inotifyWatches': <String, Object?>{'used': 4, 'limit': null, 'headroom': null},
+            'epollInstances': 2,
+            'epollWatches': <String, Object?>{'used': 9, 'limit': 1000, 'headroom': 0.991},
+          };
+        }
+        if (methodCall.method == 'getFileUsage') {
+          return <String, Object?>{
+            'files': <Object?>[
+              <String, Object?>{
+                'dev': 2049,
+                'inode': 77,
+                'path': '/var/log/app.log',
+                'state': 'both',
+                'deleted': true,
+                'fds': <Object?>[5, 6],
+                'mappingCount': 1,
+                'mappedBytes': 8192,
+                'size': 10000,
+                'diskBytes': 12288,
+                'reclaimableBytes': 12288,
+              },
+              <String, Object?>{
+                'dev': 2049,
+                'inode': 78,
+                'path': '/usr/lib/libfoo.so',
+                'state': 'mapped',
+                'deleted': false,
+                'fds': <Object?>[],
+                'mappingCount': 4,
+                'mappedBytes': 65536,
+                'size': null,
+                'diskBytes': null,
+                'reclaimableBytes': 0,
+              },
+            ],
+            'deletedFileCount': 1,
+            'deletedReclaimableBytes': 12288,
+          };
+        }
+        if (methodCall.method == 'getUnixSocketPeers') {
+          lastArguments = methodCall.arguments;
+          return <String, Object?>{
+            'sockets': <Object?>[
+              <String, Object?>{
+                'fd': 12,
+                'inode': 4242,
+                'local': 'unix:(anonymous)',
+                'peerInode': 4243,
+                'peerPid': 811,
+                'peerFd': 3,
+                'peerComm': 'dbus-daemon',
+              },
+              <String, Object?>{
+                'fd': 13,
+                'inode': 4250,
+                'local': 'unix:/run/app.sock',
+                'peerInode': null,
+                'peerPid': null,
+                'peerFd': null,
+                'peerComm': null,
+              },
+            ],
+            'diagErrno': 0,
+            'processesScanned': 57,
+          };
+        }
+        if (methodCall.method == 'setCloexecRange' || methodCall.method == 'closeRange') {
+          lastArguments = methodCall.arguments;
+          return <String, Object?>{
+            'success': true,
+            'usedCloseRange': false,
+            'affected': 4,
+            'errno': 0,
+            'errorMessage': '',
+          };
+        }
+        if (methodCall.method == 'getNonCloexecFds') {
+          lastArguments = methodCall.arguments;
+          return <Object?>[
+            <String, Object?>{'fd': 9, 'fdType': 2, 'fdTypeName': 'SOCKET', 'fdFlags': 0},
+          ];
+        }
+        if (methodCall.method == 'setSnapshotCacheMaxAge') {
+          lastArguments = methodCall.arguments;
+          return null;
+        }
+        if (methodCall.method == 'setFdConsistencyMode') {
+          lastArguments = methodCall.arguments;
+          return null;
+        }
+        if (methodCall.method == 'setFdProbeBackend') {
+          lastArguments = methodCall.arguments;
+          return 'io_uring';
+        }
+        if (methodCall.method == 'enableEmergencyFdDump') {
+          lastArguments = methodCall.arguments;
+          return null;
+        }
+        if (methodCall.method == 'triggerEmergencyFdDump') {
+          return 512;
+        }
+        if (methodCall.method == 'enableShmPublisher') {
+          lastArguments = methodCall.arguments;
+          return <String, Object?>{
+            'path': '/proc/100/fd/9',
+            'fd': 9,
+            'segmentSize': 33024,
+            'capacity': 1024,
+            'intervalMs': 250,
+          };
+        }
+        if (methodCall.method == 'startFdTrace' || methodCall.method == 'stopFdTrace') {
+          lastArguments = methodCall.arguments;
+          final bool stopped = methodCall.method == 'stopFdTrace';
+          return <String, Object?>{
+            'active': !stopped,
+            'path': '/tmp/fds.json',
+            'intervalMs': 500,
+            'maxBytes': 1048576,
+            'bytesWritten': stopped ? 4096 : 0,
+            'samples': stopped ? 12 : 0,
+            'opened': stopped ? 30 : 0,
+            'closed': stopped ? 30 : 0,
+            'truncated': false,
+            'writeErrno': 0,
+          };
+        }
         return null;
       },
     );
@@ -61,6 +272,137 @@ void main() {
 
   test('getFdReport', () async {
     expect(await platform.getFdReport(), '42');
+    expect(lastArguments, isNull);
+  });
+
+  test('getFdReport with maxAge', () async {
+    expect(await platform.getFdReport(maxAge: const Duration(milliseconds: 250)), '42');
+    expect(lastArguments, <String, Object?>{'maxAgeMs': 250});
+  });
+
+  test('getFdListPage', () async {
+    final token = FdCancellationToken();
+    final page = await platform.getFdListPage(
+      budget: const FdCollectionBudget(timeBudget: Duration(milliseconds: 5), startFd: 3),
+      cancelToken: token,
+    );
+    expect(lastArguments, <String, Object?>{
+      'startFd': 3,
+      'timeBudgetMs': 5,
+      'requestId': token.id,
+    });
+    expect(page.entries.single.fd, 7);
+    expect(page.truncated, true);
+    expect(page.timings[FdPhase.readlink], const Duration(microseconds: 12));
+    expect(page.timings[FdPhase.encode], Duration.zero);
+    expect(page.nextFd, 8);
+  });
+
+  test('cancelFdCollection', () async {
+    final token = FdCancellationToken();
+    expect(await platform.cancelFdCollection(token), true);
+    expect(lastArguments, <String, Object?>{'requestId': token.id});
+  });
+
+  test('streamFdReportChunks', () async {
+    Object? listenArguments;
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockStreamHandler(
+      platform.reportStreamChannel,
+      MockStreamHandler.inline(
+        onListen: (Object? arguments, MockStreamHandlerEventSink events) {
+          listenArguments = arguments;
+          events.success(Uint8List.fromList(<int>[123, 125, 10]));
+          events.success(Uint8List.fromList(<int>[10]));
+          events.endOfStream();
+        },
+      ),
+    );
+    addTearDown(() {
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockStreamHandler(
+        platform.reportStreamChannel,
+        null,
+      );
+    });
+
+    final chunks = await platform.streamFdReportChunks(chunkSize: 8192).toList();
+    expect(listenArguments, <String, Object?>{'chunkSize': 8192});
+    expect(chunks.map((c) => c.length), <int>[3, 1]);
+  });
+
+  test('getCollectorStats', () async {
+    final stats = await platform.getCollectorStats(reset: true);
+    expect(lastArguments, <String, Object?>{'reset': true});
+    expect(stats.window, const Duration(minutes: 1));
+    expect(stats.phases.keys, <FdPhase>[FdPhase.fstat]);
+    expect(stats.phases[FdPhase.fstat]!.p50, const Duration(microseconds: 3));
+    expect(stats.phases[FdPhase.fstat]!.buckets.length, 3);
+    expect(stats.methods['getFdList']!.p50, const Duration(milliseconds: 2));
+  });
+
+  test('getFdPressure', () async {
+    final pressure = await platform.getFdPressure();
+    expect(pressure.processFds.used, 12);
+    expect(pressure.processFds.limit, 1024);
+    expect(pressure.nofileHard, 4096);
+    expect(pressure.systemFiles.headroom, 0.995);
+    expect(pressure.inotifyInstances.used, 1);
+    expect(pressure.inotifyWatches.limit, isNull);
+    expect(pressure.inotifyWatches.headroom, isNull);
+    expect(pressure.epollInstances, 2);
+    expect(pressure.epollWatches.used, 9);
+  });
+
+  test('getFileUsage', () async {
+    final usage = await platform.getFileUsage();
+    expect(usage.deletedFileCount, 1);
+    expect(usage.deletedReclaimableBytes, 12288);
+    expect(usage.files.first.state, FileUsageState.openAndMapped);
+    expect(usage.files.first.fds, <int>[5, 6]);
+    expect(usage.files.last.state, FileUsageState.mappedOnly);
+    expect(usage.files.last.size, isNull);
+  });
+
+  test('getUnixSocketPeers', () async {
+    final report = await platform.getUnixSocketPeers(maxAge: const Duration(seconds: 1));
+    expect(lastArguments, <String, Object?>{'maxAgeMs': 1000});
+    expect(report.processesScanned, 57);
+    expect(report.sockets.first.peerPid, 811);
+    expect(report.sockets.first.peerComm, 'dbus-daemon');
+    expect(report.sockets.last.local, 'unix:/run/app.sock');
+    expect(report.sockets.last.peerInode, isNull);
+  });
+
+  test('setCloexecRange', () async {
+    final result = await platform.setCloexecRange(3);
+    expect(lastArguments, <String, Object?>{'first': 3});
+    expect(result.success, true);
+    expect(result.affected, 4);
+  });
+
+  test('closeRange', () async {
+    await platform.closeRange(10, 20);
+    expect(lastArguments, <String, Object?>{'first': 10, 'last': 20});
+  });
+
+  test('getNonCloexecFds', () async {
+    final list = await platform.getNonCloexecFds();
+    expect(lastArguments, <String, Object?>{'includeStdio': false});
+    expect(list.single.fd, 9);
+  });
+
+  test('setSnapshotCacheMaxAge', () async {
+    await platform.setSnapshotCacheMaxAge(const Duration(seconds: 1));
+    expect(lastArguments, <String, Object?>{'maxAgeMs': 1000});
+  });
+
+  test('setFdProbeBackend', () async {
+    expect(await platform.setFdProbeBackend(FdProbeBackend.ioUring), FdProbeBackend.ioUring);
+    expect(lastArguments, <String, Object?>{'backend': 'io_uring'});
+  });
+
+  test('setFdConsistencyMode', () async {
+    await platform.setFdConsistencyMode(FdConsistencyMode.mark);
+    expect(lastArguments, <String, Object?>{'mode': 'mark'});
   });
 
   test('getNofileLimit', () async {
@@ -81,10 +423,64 @@ void main() {
     expect(list.first.vnode?.size, 12);
   });
 
+  test('getFdSnapshot', () async {
+    final snapshot = await platform.getFdSnapshot(maxAge: const Duration(milliseconds: 200));
+    expect(lastArguments, <String, Object?>{'maxAgeMs': 200});
+    expect(snapshot.report, startsWith('fd_count: 2'));
+    expect(snapshot.entries.length, 2);
+    expect(snapshot.entries.last.socket?.family, 1);
+    expect(snapshot.entries.first.torn, false);
+    expect(snapshot.entries.last.torn, true);
+    expect(snapshot.summary.socketCount, 1);
+    expect(snapshot.summary.limit.hard, 524288);
+    expect(snapshot.summary.snapshotAge, const Duration(microseconds: 1500));
+    expect(snapshot.timings[FdPhase.encode], const Duration(microseconds: 3));
+  });
+
   test('setNofileSoftLimit', () async {
     final result = await platform.setNofileSoftLimit(4096);
     expect(result.success, true);
     expect(result.requestedSoft, 4096);
     expect(result.appliedSoft, 4096);
   });
+
+  test('enableEmergencyFdDump/triggerEmergencyFdDump', () async {
+    await platform.enableEmergencyFdDump('/tmp/fd_dump.txt', triggerSignal: 12);
+    expect(lastArguments, <String, Object?>{
+      'path': '/tmp/fd_dump.txt',
+      'triggerSignal': 12,
+      'dumpOnFatalSignal': true,
+      'dumpOnEmfile': true,
+    });
+    expect(await platform.triggerEmergencyFdDump(), 512);
+  });
+
+  test('enableShmPublisher', () async {
+    final info = await platform.enableShmPublisher(
+      interval: const Duration(milliseconds: 250),
+      capacity: 1024,
+    );
+    expect(lastArguments, <String, Object?>{'intervalMs': 250, 'capacity': 1024});
+    expect(info.path, '/proc/100/fd/9');
+    expect(info.fd, 9);
+    expect(info.segmentSize, 33024);
+    expect(info.interval, const Duration(milliseconds: 250));
+  });
+
+  test('startFdTrace/stopFdTrace', () async {
+    final started = await platform.startFdTrace(
+      '/tmp/fds.json',
+      interval: const Duration(milliseconds: 500),
+      maxBytes: 1048576,
+    );
+    expect(lastArguments, <String, Object?>{'path': '/tmp/fds.json', 'intervalMs': 500, 'maxBytes': 1048576});
+    expect(started.active, true);
+    expect(started.interval, const Duration(milliseconds: 500));
+
+    final stopped = await platform.stopFdTrace();
+    expect(stopped.active, false);
+    expect(stopped.samples, 12);
+    expect(stopped.opened, stopped.closed);
+    expect(stopped.bytesWritten, 4096);
+  });
 }
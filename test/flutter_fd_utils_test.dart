@@ -1,3 +1,6 @@
+import 'dart:convert';
+import 'dart:typed_data';
+
 import 'package:flutter_test/flutter_test.dart';
 import 'package:flutter_fd_utils/flutter_fd_utils.dart';
 import 'package:flutter_fd_utils/flutter_fd_utils_platform_interface.dart';
@@ -9,7 +12,12 @@ class MockFlutterFdUtilsPlatform
   implements FlutterFdUtilsPlatform {
 
   @override
-  Future<String> getFdReport() => Future.value('42');
+  Future<String> getFdReport({
+    Duration? maxAge,
+    FdCollectionBudget? budget,
+    FdCancellationToken? cancelToken,
+  }) =>
+      Future.value('42');
 
   @override
   Future<NofileLimit> getNofileLimit() {
@@ -27,7 +35,7 @@ class MockFlutterFdUtilsPlatform
   }
 
   @override
-  Future<List<FdInfo>> getFdList() {
+  Future<List<FdInfo>> getFdList({Duration? maxAge}) {
     return Future.value(
       const [
         FdInfo(fd: 3, fdType: 1, fdTypeName: 'VNODE'),
@@ -35,6 +43,28 @@ class MockFlutterFdUtilsPlatform
     );
   }
 
+  @override
+  Future<FdSnapshot> getFdSnapshot({Duration? maxAge}) {
+    return Future.value(
+      const FdSnapshot(
+        report: 'fd_count: 1',
+        entries: [
+          FdInfo(fd: 3, fdType: 1, fdTypeName: 'VNODE'),
+        ],
+        summary: FdSummary(
+          fdCount: 1,
+          vnodeCount: 1,
+          socketCount: 0,
+          pipeCount: 0,
+          unknownCount: 0,
+          nonCloexecCount: 1,
+          limit: NofileLimit(soft: 1024, hard: 4096),
+          snapshotAge: Duration.zero,
+        ),
+      ),
+    );
+  }
+
   @override
   Future<NofileLimitResult> setNofileSoftLimit(
     int softLimit, {
@@ -54,6 +84,206 @@ class MockFlutterFdUtilsPlatform
       ),
     );
   }
+
+  @override
+  Future<FdListPage> getFdListPage({
+    FdCollectionBudget budget = const FdCollectionBudget(),
+    FdCancellationToken? cancelToken,
+  }) {
+    return Future.value(
+      const FdListPage(
+        entries: [FdInfo(fd: 3, fdType: 1, fdTypeName: 'VNODE')],
+        truncated: true,
+        nextFd: 4,
+      ),
+    );
+  }
+
+  @override
+  Future<bool> cancelFdCollection(FdCancellationToken token) => Future.value(true);
+
+  @override
+  Stream<Uint8List> streamFdReportChunks({int chunkSize = 64 * 1024}) {
+    final bytes = utf8.encode(
+      '{"type":"header","pid":1}\n'
+      '{"type":"fd","fd":3,"fdType":1,"fdTypeName":"VNODE","path":"/tmp/\\u00e9"}\n'
+      '{"type":"summary","fdCount":1}\n',
+    );
+    // Split mid-record to exercise reassembly.
+    return Stream<Uint8List>.fromIterable(<Uint8List>[
+      Uint8List.fromList(bytes.sublist(0, 30)),
+      Uint8List.fromList(bytes.sublist(30)),
+    ]);
+  }
+
+  @override
+  Future<FdCollectorStats> getCollectorStats({bool reset = false}) {
+    return Future.value(
+      const FdCollectorStats(
+        window: Duration(minutes: 1),
+        phases: <FdPhase, FdLatencyHistogram>{
+          FdPhase.readlink: FdLatencyHistogram(
+            count: 2,
+            min: Duration(microseconds: 100),
+            max: Duration(microseconds: 300),
+            mean: Duration(microseconds: 200),
+            p50: Duration(microseconds: 100),
+            p90: Duration(microseconds: 300),
+            p99: Duration(microseconds: 300),
+            p999: Duration(microseconds: 300),
+          ),
+        },
+        methods: <String, FdLatencyHistogram>{},
+      ),
+    );
+  }
+
+  @override
+  Future<FdPressure> getFdPressure() {
+    return Future.value(
+      const FdPressure(
+        processFds: FdPressureGauge(used: 10, limit: 100, headroom: 0.9),
+        nofileHard: 200,
+        systemFiles: FdPressureGauge(used: 500, limit: 1000, headroom: 0.5),
+        inotifyInstances: FdPressureGauge(used: 1, limit: 128, headroom: 0.9921875),
+        inotifyWatches: FdPressureGauge(used: 8, limit: 8192, headroom: 0.9990234375),
+        epollInstances: 1,
+        epollWatches: FdPressureGauge(used: 3, limit: 1000, headroom: 0.997),
+      ),
+    );
+  }
+
+  @override
+  Future<FileUsageReport> getFileUsage() {
+    return Future.value(
+      const FileUsageReport(
+        files: [
+          FileUsage(
+            dev: 1,
+            inode: 2,
+            path: '/tmp/log',
+            state: FileUsageState.openOnly,
+            deleted: true,
+            fds: [7],
+            mappingCount: 0,
+            mappedBytes: 0,
+            size: 10,
+            diskBytes: 4096,
+            reclaimableBytes: 4096,
+          ),
+        ],
+        deletedFileCount: 1,
+        deletedReclaimableBytes: 4096,
+      ),
+    );
+  }
+
+  @override
+  Future<UnixSocketPeerReport> getUnixSocketPeers({Duration? maxAge}) {
+    return Future.value(
+      const UnixSocketPeerReport(
+        sockets: [
+          UnixSocketPeer(fd: 9, inode: 100, local: 'unix:(anonymous)', peerInode: 101, peerPid: 42, peerFd: 4, peerComm: 'helper'),
+        ],
+        diagErrno: 0,
+        processesScanned: 0,
+      ),
+    );
+  }
+
+  @override
+  Future<FdRangeResult> setCloexecRange(int first, [int? last]) {
+    return Future.value(
+      const FdRangeResult(success: true, usedCloseRange: true, errno: 0, errorMessage: ''),
+    );
+  }
+
+  @override
+  Future<FdRangeResult> closeRange(int first, [int? last]) {
+    return Future.value(
+      const FdRangeResult(success: true, usedCloseRange: false, affected: 2, errno: 0, errorMessage: ''),
+    );
+  }
+
+  @override
+  Future<List<FdInfo>> getNonCloexecFds({bool includeStdio = false}) {
+    return Future.value(const [FdInfo(fd: 5, fdType: 6, fdTypeName: 'PIPE', fdFlags: 0)]);
+  }
+
+  @override
+  Future<void> setSnapshotCacheMaxAge(Duration maxAge) => Future.value();
+
+  @override
+  Future<FdProbeBackend> setFdProbeBackend(FdProbeBackend backend) => Future.value(FdProbeBackend.syscalls);
+
+  @override
+  Future<void> setFdConsistencyMode(FdConsistencyMode mode) => Future.value();
+
+  @override
+  Future<void> enableEmergencyFdDump(
+    String path, {
+    int? triggerSignal,
+    bool dumpOnFatalSignal = true,
+    bool dumpOnEmfile = true,
+  }) {
+    return Future.value();
+  }
+
+  @override
+  Future<void> disableEmergencyFdDump() => Future.value();
+
+  @override
+  Future<int> triggerEmergencyFdDump() => Future.value(512);
+
+  @override
+  Future<ShmPublisherInfo> enableShmPublisher({
+    String? name,
+    Duration interval = const Duration(seconds: 1),
+    int capacity = 4096,
+  }) {
+    return Future.value(
+      ShmPublisherInfo(
+        path: '/dev/shm${name ?? '/anon'}',
+        fd: 42,
+        segmentSize: 256 + capacity * 32,
+        capacity: capacity,
+        interval: interval,
+      ),
+    );
+  }
+
+  @override
+  Future<void> disableShmPublisher() => Future.value();
+
+  FdTraceInfo _trace(bool active, {Duration interval = const Duration(seconds: 1), int? maxBytes}) {
+    return FdTraceInfo(
+      active: active,
+      path: '/tmp/fds.json',
+      interval: interval,
+      maxBytes: maxBytes ?? 0,
+      bytesWritten: active ? 0 : 2048,
+      samples: active ? 0 : 5,
+      opened: active ? 0 : 7,
+      closed: active ? 0 : 7,
+      truncated: false,
+      writeErrno: 0,
+    );
+  }
+
+  @override
+  Future<FdTraceInfo> startFdTrace(
+    String path, {
+    Duration interval = const Duration(seconds: 1),
+    int? maxBytes,
+  }) {
+    return Future.value(_trace(true, interval: interval, maxBytes: maxBytes));
+  }
+
+  @override
+  Future<FdTraceInfo> getFdTraceInfo() => Future.value(_trace(true));
+
+  @override
+  Future<FdTraceInfo> stopFdTrace() => Future.value(_trace(false));
 }
 
 void main() {
@@ -104,4 +334,139 @@ void main() {
     expect(list.length, 1);
     expect(list.first.fd, 3);
   });
+
+  test('getFdSnapshot', () async {
+    const FlutterFdUtils plugin = FlutterFdUtils();
+    MockFlutterFdUtilsPlatform fakePlatform = MockFlutterFdUtilsPlatform();
+    FlutterFdUtilsPlatform.instance = fakePlatform;
+
+    final snapshot = await plugin.getFdSnapshot();
+    expect(snapshot.report, 'fd_count: 1');
+    expect(snapshot.entries.single.fd, 3);
+    expect(snapshot.summary.fdCount, snapshot.entries.length);
+  });
+
+  test('getFdListPage/cancelFdCollection', () async {
+    const FlutterFdUtils plugin = FlutterFdUtils();
+    MockFlutterFdUtilsPlatform fakePlatform = MockFlutterFdUtilsPlatform();
+    FlutterFdUtilsPlatform.instance = fakePlatform;
+
+    final page = await plugin.getFdListPage(budget: const FdCollectionBudget(maxProbes: 1));
+    expect(page.truncated, true);
+    expect(page.nextFd, 4);
+    expect(await plugin.cancelFdCollection(FdCancellationToken()), true);
+  });
+
+  test('streamFdReportRecords', () async {
+    const FlutterFdUtils plugin = FlutterFdUtils();
+    MockFlutterFdUtilsPlatform fakePlatform = MockFlutterFdUtilsPlatform();
+    FlutterFdUtilsPlatform.instance = fakePlatform;
+
+    final records = await plugin.streamFdReportRecords().toList();
+    expect(records.map((r) => r['type']), <String>['header', 'fd', 'summary']);
+    expect(records[1]['path'], '/tmp/\u00e9');
+    expect(FdInfo.fromMap(records[1]).fdTypeName, 'VNODE');
+    expect(records.last['fdCount'], 1);
+  });
+
+  test('getCollectorStats', () async {
+    const FlutterFdUtils plugin = FlutterFdUtils();
+    MockFlutterFdUtilsPlatform fakePlatform = MockFlutterFdUtilsPlatform();
+    FlutterFdUtilsPlatform.instance = fakePlatform;
+
+    final stats = await plugin.getCollectorStats();
+    expect(stats.window, const Duration(minutes: 1));
+    expect(stats.phases[FdPhase.readlink]!.count, 2);
+  });
+
+  test('getFdPressure', () async {
+    const FlutterFdUtils plugin = FlutterFdUtils();
+    MockFlutterFdUtilsPlatform fakePlatform = MockFlutterFdUtilsPlatform();
+    FlutterFdUtilsPlatform.instance = fakePlatform;
+
+    final pressure = await plugin.getFdPressure();
+    expect(pressure.processFds.headroom, 0.9);
+    expect(pressure.systemFiles.used, 500);
+    expect(pressure.epollInstances, 1);
+  });
+
+  test('getFileUsage', () async {
+    const FlutterFdUtils plugin = FlutterFdUtils();
+    MockFlutterFdUtilsPlatform fakePlatform = MockFlutterFdUtilsPlatform();
+    FlutterFdUtilsPlatform.instance = fakePlatform;
+
+    final usage = await plugin.getFileUsage();
+    expect(usage.deletedReclaimableBytes, 4096);
+    expect(usage.files.single.deleted, true);
+  });
+
+  test('getUnixSocketPeers', () async {
+    const FlutterFdUtils plugin = FlutterFdUtils();
+    MockFlutterFdUtilsPlatform fakePlatform = MockFlutterFdUtilsPlatform();
+    FlutterFdUtilsPlatform.instance = fakePlatform;
+
+    final report = await plugin.getUnixSocketPeers();
+    expect(report.sockets.single.peerPid, 42);
+    expect(report.sockets.single.peerComm, 'helper');
+  });
+
+  test('setCloexecRange/closeRange/getNonCloexecFds', () async {
+    const FlutterFdUtils plugin = FlutterFdUtils();
+    MockFlutterFdUtilsPlatform fakePlatform = MockFlutterFdUtilsPlatform();
+    FlutterFdUtilsPlatform.instance = fakePlatform;
+
+    expect((await plugin.setCloexecRange(3)).usedCloseRange, true);
+    expect((await plugin.closeRange(100, 101)).affected, 2);
+    expect((await plugin.getNonCloexecFds()).single.fd, 5);
+  });
+
+  test('triggerEmergencyFdDump', () async {
+    const FlutterFdUtils plugin = FlutterFdUtils();
+    MockFlutterFdUtilsPlatform fakePlatform = MockFlutterFdUtilsPlatform();
+    FlutterFdUtilsPlatform.instance = fakePlatform;
+
+    await plugin.enableEmergencyFdDump('/tmp/fd_dump.txt');
+    expect(await plugin.triggerEmergencyFdDump(), 512);
+  });
+
+  test('enableShmPublisher/disableShmPublisher', () async {
+    const FlutterFdUtils plugin = FlutterFdUtils();
+    MockFlutterFdUtilsPlatform fakePlatform = MockFlutterFdUtilsPlatform();
+    FlutterFdUtilsPlatform.instance = fakePlatform;
+
+    final info = await plugin.enableShmPublisher(name: '/app.fds', capacity: 8);
+    expect(info.path, '/dev/shm/app.fds');
+    expect(info.segmentSize, 512);
+    await plugin.disableShmPublisher();
+  });
+
+  test('startFdTrace/stopFdTrace', () async {
+    const FlutterFdUtils plugin = FlutterFdUtils();
+    MockFlutterFdUtilsPlatform fakePlatform = MockFlutterFdUtilsPlatform();
+    FlutterFdUtilsPlatform.instance = fakePlatform;
+
+    final started = await plugin.startFdTrace('/tmp/fds.json', maxBytes: 1 << 20);
+    expect(started.active, true);
+    expect(started.maxBytes, 1 << 20);
+    expect((await plugin.getFdTraceInfo()).active, true);
+    final stopped = await plugin.stopFdTrace();
+    expect(stopped.active, false);
+    expect(stopped.samples, 5);
+  });
+
+  test('setFdProbeBackend', () async {
+    const FlutterFdUtils plugin = FlutterFdUtils();
+    MockFlutterFdUtilsPlatform fakePlatform = MockFlutterFdUtilsPlatform();
+    FlutterFdUtilsPlatform.instance = fakePlatform;
+
+    expect(await plugin.setFdProbeBackend(FdProbeBackend.ioUring), FdProbeBackend.syscalls);
+  });
+
+  test('setFdConsistencyMode', () async {
+    const FlutterFdUtils plugin = FlutterFdUtils();
+    MockFlutterFdUtilsPlatform fakePlatform = MockFlutterFdUtilsPlatform();
+    FlutterFdUtilsPlatform.instance = fakePlatform;
+
+    await plugin.setFdConsistencyMode(FdConsistencyMode.retry);
+  });
 }